@@ -6,52 +6,249 @@
 
 #include <iostream>
 #include <utility>
+#include <cstdio>
+#include <filesystem>
 
 #include "my_graph.h"
 #include "agent_function.h"
 #include "ritm_test_suppor.h"
+#include "delta_output.h"
+#include "pipeline.h"
+#include "sharding.h"
+#include "id_map.h"
 
 /* ******************************************************************************************************** */
 /*                                   ОСНОВНОЙ КОД ВЫПОЛНЕНИЯ ЗАДАЧИ                                         */
 /* ******************************************************************************************************** */
 
-[[nodiscard]] int complete_task(TInOut& IO) {
+// разбиение модели на шарды: выполнить шарды, только разбить (для внешнего запуска), только собрать результаты
+enum TShardMode { smNone = 0, smRun, smSplit, smJoin };
 
-    using TGraph = TAnnotatedGraph<float, asAll>;
-    using TRules = TRules<TGraph>;
+// параметры выполнения задачи
+struct TTaskOptions {
+    bool mapped_storage{ false }; // графы хранятся во временных файлах, отображённых в память
+    TOutputMode output{ omFull }; // полный результат или только вычисленные атрибуты
+    std::string cache_dir{}; // каталог кэша подготовленных агент-функций (пусто - без кэша)
+    TShardMode shard_mode{ smNone };
+    size_t shards{ 0 }; // количество шардов (0 - по количеству потоков)
+    std::filesystem::path self{}; // исполняемый файл для процессов шардов
+    bool external_ids{ false }; // элементы заданы внешними (разреженными) номерами
+};
 
-    try {
-        // Ввод размеров графа
-        if (IO.IsConsole()) std::cout << "Entering sizes...\n";
+// Конвейерное чтение модели из файла
+// Строки: 1 - размеры, 2 - пропуск, NE строк рёбер, пропуск, NV строк правил узлов, NE строк правил рёбер.
+// Поток чтения и поток разбиения на строки (TLineReader) подают пакеты строк, текущий поток раскладывает их по секциям:
+// рёбра строят потоки графа (параллельно, каждое ребро - в слот по номеру строки), правила передаются потоку правил (on_rules).
+// Ошибки этапов собираются, и выбрасывается первая по номеру строки - как при последовательном чтении.
+template <typename TGraph, typename TOnRules>
+void read_model_pipelined(std::istream& IN, TGraph& graph, size_t& NV, size_t& NE, TOnRules& on_rules) {
+    struct TRuleBatch {
+        Graph_Elem_Type elem_type{ getVert };
+        size_t first_idx{ 0 };
+        TLineBatch batch;
+    };
 
-        size_t NV, NE;
+    constexpr size_t depth = 8; // глубина очередей между этапами
+
+    TLineReader reader(IN);
+    TLineBatch batch;
+
+    // Ввод размеров графа
+    if (!reader.Next(batch)) batch = TLineBatch{ 1, { "" } };
+    try {
+        std::istringstream line(batch.lines[0]);
+        ReadValue(line, NV);
+        ReadValue(line, NE);
+    }
+    catch (const std::exception& exc) { throw_abort(exc.what(), 2, 1); }
 
+    // память под узлы и слоты рёбер выделяется по размерам до чтения остальных строк,
+    // поэтому невыполнимые размеры - ошибка строки размеров (а не исключение, завершающее программу)
+    auto allocate = [&] {
         try {
-            IO.ReadLine(NV, NE);
+            graph.AddVertexes(NV);
+            return graph.ConcurrentEdges(NE);
         }
-        catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
+        catch (const std::exception&) { throw_abort("Graph size is too large", 2, 1); } // bad_alloc, length_error, ошибка отображения файла
+    };
+    auto edges_builder = allocate();
 
-        TGraph graph;
-        graph.AddVertexes(NV);
-        IO.IgnorLine();
+    // границы секций [first, last)
+    size_t const edges_first = 3;
+    size_t const v_rules_first = edges_first + NE + 1;
+    size_t const e_rules_first = v_rules_first + NV;
+    size_t const end_line = e_rules_first + NE;
 
-        // Ввод рёбер
-        if (IO.IsConsole()) std::cout << "Entering edges...\n";
+    TBoundedQueue<TLineBatch> edge_queue(depth);
+    TBoundedQueue<TRuleBatch> rule_queue(depth);
+    TFirstError error;
 
-        for (size_t i = 0; i < NE; ++i) {
-            size_t vi, vo;
-            try {
-                IO.ReadLine(vi, vo);
+    // потоки построения графа
+    auto build_edges = [&] {
+        TLineBatch edges;
+        while (edge_queue.Pop(edges)) {
+            for (size_t i = 0; i < edges.lines.size(); ++i) {
+                size_t line_no = edges.first_line + i;
+                try {
+                    size_t vi, vo;
+                    try {
+                        std::istringstream line(edges.lines[i]);
+                        ReadValue(line, vi);
+                        ReadValue(line, vo);
+                    }
+                    catch (const std::exception& exc) { throw_abort(exc.what(), 2, line_no); }
+
+                    try {
+                        edges_builder.SetEdge(line_no - edges_first, vi - 1, vo - 1);
+                    }
+                    catch (const std::exception& exc) { throw_abort(exc.what(), 3, line_no); }
+                }
+                catch (const EAbort& exc) {
+                    error.Set(exc);
+                    edge_queue.Close();
+                    return;
+                }
             }
-            catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
+        }
+    };
+    std::vector<std::jthread> graph_builders(std::max(1u, std::thread::hardware_concurrency() / 2));
+    for (auto& builder : graph_builders) builder = std::jthread(build_edges);
 
+    // поток разбора правил
+    std::jthread rule_builder([&] {
+        TRuleBatch rules;
+        while (rule_queue.Pop(rules)) {
             try {
-                graph.AddEdge(vi - 1, vo - 1);
+                on_rules(rules.elem_type, rules.first_idx, std::move(rules.batch.lines), rules.batch.first_line);
             }
-            catch (const std::exception& exc) { throw_abort(exc.what(), 3); }
+            catch (const EAbort& exc) {
+                error.Set(exc);
+                rule_queue.Close();
+                return;
+            }
+        }
+    });
+
+    // раскладка пакета по секциям
+    auto route = [&](TLineBatch& src) {
+        size_t src_last = src.first_line + src.lines.size();
+        auto slice = [&](size_t first, size_t last) {
+            first = std::max(first, src.first_line);
+            last = std::min(last, src_last);
+            TLineBatch part{ first, {} };
+            if (first < last) {
+                part.lines.assign(std::make_move_iterator(src.lines.begin() + (first - src.first_line)),
+                                  std::make_move_iterator(src.lines.begin() + (last - src.first_line)));
+            }
+            return part;
+        };
+        if (TLineBatch part = slice(edges_first, v_rules_first - 1); !part.lines.empty()) {
+            edge_queue.Push(std::move(part));
+        }
+        if (TLineBatch part = slice(v_rules_first, e_rules_first); !part.lines.empty()) {
+            size_t first_idx = part.first_line - v_rules_first;
+            rule_queue.Push(TRuleBatch{ getVert, first_idx, std::move(part) });
+        }
+        if (TLineBatch part = slice(e_rules_first, end_line); !part.lines.empty()) {
+            size_t first_idx = part.first_line - e_rules_first;
+            rule_queue.Push(TRuleBatch{ getEdge, first_idx, std::move(part) });
         }
-        IO.IgnorLine();
+    };
 
+    size_t next_line = batch.first_line + batch.lines.size();
+    route(batch);
+    while (next_line < end_line and !error.Any() and reader.Next(batch)) {
+        next_line = batch.first_line + batch.lines.size();
+        route(batch);
+    }
+    reader.Stop();
+
+    // файл закончился раньше: первая недостающая строка читается как пустая (как и при последовательном чтении)
+    if (next_line < end_line and !error.Any()) {
+        if (next_line == edges_first - 1 or next_line == v_rules_first - 1) ++next_line;
+        if (next_line < end_line) {
+            TLineBatch empty{ next_line, { "" } };
+            route(empty);
+        }
+    }
+
+    edge_queue.Close();
+    rule_queue.Close();
+    for (auto& builder : graph_builders) builder.join();
+    rule_builder.join();
+
+    error.ThrowIfAny();
+    edges_builder.Publish();
+}
+
+// Чтение модели с внешними номерами элементов (параметр -ids)
+// Строки: 1 - размеры, 2 - пропуск, NE строк рёбер "<номер ребра> <номер узла from> <номер узла to>", пропуск,
+// NV строк "<номер узла> <правило>", NE строк "<номер ребра> <правило>" (в порядке строк рёбер).
+// Внутренние номера - порядок строк, поэтому рёбра добавляются в граф после чтения номеров узлов.
+template <typename TGraph, typename TOnRules>
+void read_model_ids(TInOut& IO, TGraph& graph, size_t& NV, size_t& NE, TIdMap& vert_ids, TIdMap& edge_ids, TOnRules& on_rules) {
+    try {
+        IO.ReadLine(NV, NE);
+    }
+    catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
+
+    // память по размерам выделяется сразу: невыполнимые размеры - ошибка строки размеров
+    std::vector<std::pair<uint64_t, uint64_t>> ends; // концы рёбер (внешние номера узлов)
+    try {
+        ends.resize(NE);
+        edge_ids.reserve(NE);
+        vert_ids.reserve(NV);
+        graph.AddVertexes(NV);
+    }
+    catch (const std::exception&) { throw_abort("Graph size is too large", 2, 1); }
+    IO.IgnorLine();
+
+    size_t const edges_first = IO.CurInputLine() + 1;
+    for (auto& [from, to] : ends) {
+        uint64_t id;
+        try {
+            IO.ReadLine(id, from, to);
+        }
+        catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
+        edge_ids.Add(id);
+    }
+    IO.IgnorLine();
+
+    size_t const v_first_line = IO.CurInputLine() + 1;
+    std::vector<std::string> v_lines = IO.ReadLines(NV);
+    size_t const e_first_line = IO.CurInputLine() + 1;
+    std::vector<std::string> e_lines = IO.ReadLines(NE);
+
+    for (size_t i = 0; i < NV; ++i) {
+        uint64_t id;
+        try {
+            std::istringstream line(v_lines[i]);
+            ReadValue(line, id);
+        }
+        catch (const std::exception& exc) { throw_abort(exc.what(), 2, v_first_line + i); }
+        vert_ids.Add(id);
+    }
+    if (size_t dup = vert_ids.Build(); dup != TIdMap::npos) throw_abort("Duplicate vertex id: " + std::to_string(vert_ids.Id(dup)), 3, v_first_line + dup);
+    if (size_t dup = edge_ids.Build(); dup != TIdMap::npos) throw_abort("Duplicate edge id: " + std::to_string(edge_ids.Id(dup)), 3, edges_first + dup);
+
+    for (size_t i = 0; i < NE; ++i) {
+        try {
+            graph.AddEdge(vert_ids.Find(ends[i].first), vert_ids.Find(ends[i].second)); // неизвестный номер - npos
+        }
+        catch (const std::exception& exc) { throw_abort(exc.what(), 3, edges_first + i); }
+    }
+
+    on_rules(getVert, 0, std::move(v_lines), v_first_line);
+    on_rules(getEdge, 0, std::move(e_lines), e_first_line);
+}
+
+template <typename storage_policy>
+[[nodiscard]] int complete_task(TInOut& IO, TTaskOptions const& options) {
+
+    using TGraph = TAnnotatedGraph<float, asAll, size_t, storage_policy, tsNone>; // целевой граф не обходится, списки смежности не нужны
+    using TRules = TRules<TGraph>;
+
+    try {
         // Создаём агент-функцию и регестрируем функции
         TRules agent_func;
         agent_func.RegFunc("min", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] < v[1] ? v[0] : v[1]; });
@@ -60,19 +257,140 @@
         agent_func.RegFunc("-", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] - v[1]; });
         agent_func.RegFunc("*", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] * v[1]; });
         agent_func.RegFunc("/", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] / v[1]; });
+        agent_func.RegReductions(); // sum, min, max, mean, dot с переменным количеством аргументов
 
-        // Читаем правила для агент-функции
-        try {
-            for (size_t i = 0; i < NV; ++i) {
-                auto str = IO.ReadLine();
-                agent_func.ReadMainRule(getVert, i, str);
+        size_t NV, NE;
+
+        // разбор пакета строк правил (строки пакета разбираются параллельно)
+        // правила читаются после строки размеров, поэтому ссылки проверяются по NV и NE
+        auto parse_rules = [&](Graph_Elem_Type elem_type, size_t first_idx, std::vector<std::string> const& lines, size_t first_line) {
+            try {
+                agent_func.SetSizes(NV, NE);
+                agent_func.ReadMainRules(elem_type, first_idx, lines);
+            }
+            catch (const ELine& exc) { throw_abort(exc.what(), 2, first_line + exc.line()); }
+            catch (const std::exception& exc) { throw_abort(exc.what(), 2, first_line); }
+        };
+
+        // строки правил разбираются сразу, а при использовании кэша - накапливаются для вычисления ключа
+        bool use_cache = !options.cache_dir.empty();
+        std::vector<std::string> v_lines, e_lines;
+        size_t v_first_line = 0, e_first_line = 0;
+        auto on_rules = [&](Graph_Elem_Type elem_type, size_t first_idx, std::vector<std::string>&& lines, size_t first_line) {
+            if (!use_cache) return parse_rules(elem_type, first_idx, lines, first_line);
+
+            auto& dest = elem_type == getVert ? v_lines : e_lines;
+            if (dest.empty()) (elem_type == getVert ? v_first_line : e_first_line) = first_line;
+            dest.insert(dest.end(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+        };
+
+        TGraph graph;
+
+        // внешние номера элементов: ссылки в правилах разрешаются через отображения номеров
+        TIdMap vert_ids, edge_ids;
+        if (options.external_ids) {
+            agent_func.SetIdResolver([&](Graph_Elem_Type type, uint64_t id) {
+                size_t idx = (type == getVert ? vert_ids : edge_ids).Find(id);
+                if (idx == TIdMap::npos) throw std::runtime_error(std::string("Unknown id: ") + (type == getVert ? "v " : "e ") + std::to_string(id));
+                return idx;
+            });
+        }
+
+        if (options.external_ids) {
+            read_model_ids(IO, graph, NV, NE, vert_ids, edge_ids, on_rules);
+        }
+        else if (IO.IsConsole()) {
+            // Ввод размеров графа
+            std::cout << "Entering sizes...\n";
+
+            try {
+                IO.ReadLine(NV, NE);
             }
+            catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
+
+            try {
+                graph.AddVertexes(NV);
+            }
+            catch (const std::exception&) { throw_abort("Graph size is too large", 2); }
+            IO.IgnorLine();
+
+            // Ввод рёбер
+            std::cout << "Entering edges...\n";
+
             for (size_t i = 0; i < NE; ++i) {
-                auto str = IO.ReadLine();
-                agent_func.ReadMainRule(getEdge, i, str);
+                size_t vi, vo;
+                try {
+                    IO.ReadLine(vi, vo);
+                }
+                catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
+
+                try {
+                    graph.AddEdge(vi - 1, vo - 1);
+                }
+                catch (const std::exception& exc) { throw_abort(exc.what(), 3); }
+            }
+            IO.IgnorLine();
+
+            // Читаем правила для агент-функции
+            for (auto [elem_type, count] : { std::pair{ getVert, NV }, std::pair{ getEdge, NE } }) {
+                size_t first_line = IO.CurInputLine() + 1;
+                on_rules(elem_type, 0, IO.ReadLines(count), first_line);
+            }
+        }
+        else {
+            // из файла: чтение, построение графа и разбор правил идут одновременно
+            read_model_pipelined(IO.IN(), graph, NV, NE, on_rules);
+        }
+
+        if (use_cache) {
+            v_lines.resize(NV);
+            e_lines.resize(NE);
+        }
+
+        // подготовленная агент-функция берётся из кэша, если он задан и правила с функциями не менялись
+        std::filesystem::path cache_file;
+        uint64_t cache_key = 0;
+        bool cached = false;
+        if (!options.cache_dir.empty()) {
+            // при внешних номерах ссылки "e <номер>" разрешаются по порядку строк рёбер, которых нет в строках правил,
+            // поэтому в ключ входит вся нумерация (внешние номера в порядке внутренних)
+            uint64_t numbering = 0;
+            if (options.external_ids) {
+                THash h;
+                for (size_t i = 0; i < NV; ++i) h.add(vert_ids.Id(i));
+                for (size_t i = 0; i < NE; ++i) h.add(edge_ids.Id(i));
+                numbering = h.value;
+            }
+            cache_key = agent_func.CacheKey(v_lines, e_lines, numbering);
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.garc", static_cast<unsigned long long>(cache_key));
+            cache_file = std::filesystem::path(options.cache_dir) / name;
+            try {
+                agent_func.SetSizes(NV, NE);
+                cached = agent_func.LoadCache(cache_file, cache_key);
+            }
+            catch (const std::exception&) { cached = false; } // испорченный кэш просто пересобирается
+        }
+
+        if (!cached) {
+            if (use_cache) {
+                parse_rules(getVert, 0, v_lines, v_first_line);
+                parse_rules(getEdge, 0, e_lines, e_first_line);
+            }
+
+            try {
+                agent_func.GetReady();
+            }
+            catch (const std::exception& exc) { throw_abort(exc.what(), 3); }
+
+            if (!cache_file.empty()) {
+                try {
+                    std::filesystem::create_directories(cache_file.parent_path());
+                    agent_func.SaveCache(cache_file, cache_key);
+                }
+                catch (const std::exception& exc) { std::cerr << "Кэш не сохранён: " << exc.what() << std::endl; }
             }
         }
-        catch (const std::exception& exc) { throw_abort(exc.what(), 2); }
 
         // Вычисляем (применяем к графу)
         agent_func.SetOn(graph);
@@ -80,32 +398,49 @@
         // Заисываем результат
         if (IO.IsConsole()) std::cout << "\nOutputting results...\n";
 
-        for (size_t i = 0; i < NV; i++) {
-            IO << graph.vertex[i].attribute << std::endl;
+        if (options.output == omFull) {
+            // при внешних номерах строка результата - "<номер> <значение>"
+            for (size_t i = 0; i < NV; i++) {
+                if (options.external_ids) IO << vert_ids.Id(i) << ' ';
+                IO << graph.vertex[i].attribute << '\n';
+            }
+            for (size_t i = 0; i < NE; i++) {
+                if (options.external_ids) IO << edge_ids.Id(i) << ' ';
+                IO << graph.edge[i].attribute << '\n';
+            }
         }
-        for (size_t i = 0; i < NE; i++) {
-            IO << graph.edge[i].attribute << std::endl;
+        else {
+            // в консоль двоичная дельта не выводится
+            TOutputMode mode = IO.IsConsole() ? omDeltaText : options.output;
+            WriteDelta(IO.OUT(), mode, graph, agent_func.Computed(getVert, NV), agent_func.Computed(getEdge, NE));
         }
+        IO.OUT().flush();
     }
     catch (const EAbort& exc) {
         std::string mes;
-        if (exc.exit_code() == 2) mes = "Error in line #" + std::to_string(IO.CurInputLine()) + ". ";
+        if (exc.exit_code() == 2) mes = "Error in line #" + std::to_string(exc.line() ? exc.line() : IO.CurInputLine()) + ". ";
         mes += exc.what();
 
         std::ostream& err_out = IO.IsConsole() ? std::cerr : IO.OUT();
-        err_out << std::endl << exc.what() << std::endl;
+        err_out << std::endl << mes << std::endl;
         return exc.exit_code();
     }
 
     return 0;
 }
 
-[[nodiscard]] int complete_task_by_file(std::string const& fin_name) {
+[[nodiscard]] int complete_task(TInOut& IO, TTaskOptions const& options) {
+    return options.mapped_storage
+        ? complete_task<TMappedStorage>(IO, options)
+        : complete_task<TVectorStorage>(IO, options);
+}
+
+[[nodiscard]] int complete_task_by_file(std::string const& fin_name, TTaskOptions const& options = {}) {
     bool f{ false };
     try {
-        TInOut IO(fin_name);
+        TInOut IO(fin_name, options.output == omDeltaBinary);
         f = true;
-        return complete_task(IO);
+        return complete_task(IO, options);
     }
     catch (const std::exception& exc) {
         if (f) throw;
@@ -114,6 +449,107 @@
     }
 }
 
+// наложение дельты на полный результат, результат записывается в "<дельта>.full"
+[[nodiscard]] int merge_delta_files(std::string const& base_name, std::string const& delta_name) {
+    std::ifstream base(base_name);
+    if (base.fail()) { std::cerr << "Ошибка при открытия файла: \"" << base_name << "\"\n"; return 1; }
+    std::ifstream delta(delta_name, std::ios::binary);
+    if (delta.fail()) { std::cerr << "Ошибка при открытия файла: \"" << delta_name << "\"\n"; return 1; }
+    std::ofstream out(delta_name + ".full");
+    if (out.fail()) { std::cerr << "Ошибка при открытия файла: \"" << delta_name << ".full\"\n"; return 1; }
+
+    try {
+        MergeDelta<float>(base, delta, out);
+    }
+    catch (const std::exception& exc) {
+        std::cerr << std::endl << exc.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
+
+// Выполнение модели по шардам (каталог шардов - "<входной файл>.shards")
+// Каждый шард выполняется отдельным процессом этой же программы, результаты собираются в "<входной файл>.out".
+// Ошибки разбиения сообщаются по строкам исходного файла, ошибки шардов - по строкам файлов шардов.
+[[nodiscard]] int complete_task_sharded(std::string const& fin_name, TTaskOptions const& options) {
+    std::filesystem::path dir = fin_name + ".shards";
+    std::vector<int> codes; // коды завершения процессов шардов
+
+    std::ofstream out;
+    auto open_out = [&]() {
+        out.open(fin_name + ".out");
+        if (out.fail()) throw std::runtime_error("Ошибка при открытия файла: \"" + fin_name + ".out\"");
+    };
+
+    if (options.shard_mode != smJoin and std::ifstream(fin_name).fail()) {
+        std::cerr << std::endl << "Ошибка при открытия файла: \"" << fin_name << "\"" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (options.shard_mode != smJoin) {
+            size_t shards = options.shards ? options.shards : std::max(1u, std::thread::hardware_concurrency());
+            auto files = SplitModel(fin_name, dir, shards);
+
+            if (options.shard_mode == smSplit) {
+                // внешнему запуску - список файлов шардов
+                for (auto const& file : files) std::cout << file.string() << '\n';
+                return 0;
+            }
+
+            std::vector<std::string> worker_args;
+            if (options.mapped_storage) worker_args.push_back("-m");
+            if (!options.cache_dir.empty()) {
+                worker_args.push_back("-cache");
+                worker_args.push_back(options.cache_dir);
+            }
+
+            // процессов одновременно - не больше, чем потоков
+            codes.assign(files.size(), 0);
+            std::atomic<size_t> next{ 0 };
+            size_t workers_count = std::min<size_t>(files.size(), std::max(1u, std::thread::hardware_concurrency()));
+            {
+                std::vector<std::jthread> workers;
+                for (size_t w = 0; w < workers_count; ++w) {
+                    workers.emplace_back([&]() {
+                        for (size_t k; (k = next++) < files.size(); ) {
+                            auto args = worker_args;
+                            args.push_back(files[k].string());
+                            codes[k] = RunProcess(options.self, args);
+                        }
+                    });
+                }
+            }
+        }
+
+        open_out();
+        JoinModel(dir, out);
+        out.flush();
+    }
+    catch (const EAbort& exc) {
+        std::string mes;
+        if (exc.exit_code() == 2) mes = "Error in line #" + std::to_string(exc.line()) + ". ";
+        mes += exc.what();
+
+        if (!out.is_open()) open_out();
+        out << std::endl << mes << std::endl;
+        return exc.exit_code();
+    }
+    catch (const std::exception& exc) {
+        // код завершения - первого неудачного шарда
+        int code = 1;
+        for (int c : codes) if (c != 0) { code = c > 0 ? c : 1; break; }
+
+        if (out.is_open()) out.close();
+        try { open_out(); }
+        catch (const std::exception&) { std::cerr << std::endl << exc.what() << std::endl; return code; }
+        out << std::endl << exc.what() << std::endl;
+        return code;
+    }
+
+    return 0;
+}
+
 #ifndef TEST_MODE
 
 /* ******************************************************************************************************** */
@@ -126,17 +562,37 @@ int main(int argc, char* argv[])
 {
     setlocale(LC_ALL, "");
 
-    if (argc > 1) {
+    TTaskOptions options;
+    bool console{ false };
+
+    /* Разбор параметров (предшествуют списку файлов) */
+    int first_file = 1;
+    for (; first_file < argc; ++first_file) {
         /* Вывод справки */
-        if (strcmp(argv[1], "-?") == 0) {
+        if (strcmp(argv[first_file], "-?") == 0) {
             std::cout
-                << "Использование: " << argv[0] << " [<список файлов>] [] [-c] [-?]\n"
+                << "Использование: " << argv[0] << " [-m] [-ids] [-d|-db] [-cache <каталог>] [-shards <k>|-shard-split <k>|-shard-join] [<список файлов>] [] [-c] [-?]\n"
+                << "       " << argv[0] << " -merge <результат> <дельта>\n"
                 << "\n"
                 << "Параметры:\n"
                 << "   <список файлов>   Имена файлов входных данных.\n"
                 << "                     По умолчанию имя файла: \"" << default_fin_name << "\".\n"
                 << "                     Имя файла результатов: \"<входной файл>.out\".\n"
                 << "              [-c]   Ввод/вывод осуществляется через консоль.\n"
+                << "              [-d]   Выводятся только вычисленные атрибуты (дельта) в текстовом виде.\n"
+                << "             [-db]   То же в двоичном виде.\n"
+                << "  [-merge <р> <д>]   Наложение дельты <д> на полный результат <р>, запись в \"<д>.full\".\n"
+                << " [-cache <каталог>]  Кэш подготовленных агент-функций (по хэшу правил и набора функций).\n"
+                << "     [-shards <k>]   Модель делится на <k> независимых частей (шардов) по компонентам связности,\n"
+                << "                     шарды выполняются отдельными процессами, результаты собираются в общий файл\n"
+                << "                     (0 - по количеству потоков, не больше 256; файлы шардов - в \"<входной файл>.shards\").\n"
+                << " [-shard-split <k>]  Только разбиение на шарды, список файлов шардов выводится в консоль.\n"
+                << "     [-shard-join]   Только сборка результатов шардов, выполненных внешним запуском.\n"
+                << "            [-ids]   Элементы заданы внешними 64-битными номерами (строки рёбер \"<р> <у1> <у2>\",\n"
+                << "                     строки правил \"<номер> <правило>\", ссылки \"v <номер>\"/\"e <номер>\"),\n"
+                << "                     строки результата - \"<номер> <значение>\" (только полный результат, без шардов).\n"
+                << "              [-m]   Графы хранятся во временных файлах, отображённых в память\n"
+                << "                     (для моделей, не помещающихся в оперативную память).\n"
                 << "              [-?]   Справка.\n"
                 << "\n"
                 << "Коды завершения:\n"
@@ -146,22 +602,62 @@ int main(int argc, char* argv[])
                 << "                3    невалидные входные данные\n";
             return 0;
         }
+        else if (strcmp(argv[first_file], "-c") == 0) console = true;
+        else if (strcmp(argv[first_file], "-m") == 0) options.mapped_storage = true;
+        else if (strcmp(argv[first_file], "-d") == 0) options.output = omDeltaText;
+        else if (strcmp(argv[first_file], "-db") == 0) options.output = omDeltaBinary;
+        else if (strcmp(argv[first_file], "-cache") == 0) {
+            if (first_file + 1 >= argc) { std::cerr << "Параметр -cache требует имя каталога\n"; return 1; }
+            options.cache_dir = argv[++first_file];
+        }
+        else if (strcmp(argv[first_file], "-shards") == 0 or strcmp(argv[first_file], "-shard-split") == 0) {
+            if (first_file + 1 >= argc) { std::cerr << "Параметр " << argv[first_file] << " требует количество шардов\n"; return 1; }
+            options.shard_mode = strcmp(argv[first_file], "-shards") == 0 ? smRun : smSplit;
+            options.shards = std::strtoull(argv[++first_file], nullptr, 10);
+            if (options.shards > max_shards) { std::cerr << "Количество шардов - не больше " << max_shards << "\n"; return 1; }
+        }
+        else if (strcmp(argv[first_file], "-shard-join") == 0) options.shard_mode = smJoin;
+        else if (strcmp(argv[first_file], "-ids") == 0) options.external_ids = true;
+        else if (strcmp(argv[first_file], "-merge") == 0) {
+            if (first_file + 2 >= argc) { std::cerr << "Параметр -merge требует два имени файла\n"; return 1; }
+            return merge_delta_files(argv[first_file + 1], argv[first_file + 2]);
+        }
+        else break;
+    }
 
-        /* Ввод-вывод через консоль */
-        if (strcmp(argv[1], "-c") == 0) {
-            return complete_task_by_file("");
+    if (options.external_ids and (options.output != omFull or options.shard_mode != smNone)) {
+        std::cerr << "Внешние номера элементов (-ids) поддерживаются только с полным результатом и без шардов\n";
+        return 1;
+    }
+
+    /* Выполнение по шардам (только для файлов, результат - всегда полный) */
+    if (options.shard_mode != smNone) {
+        if (console or options.output != omFull) { std::cerr << "Шарды выполняются только для файлов и с полным результатом\n"; return 1; }
+        options.self = SelfPath(argv[0]);
+        if (first_file >= argc) return complete_task_sharded(default_fin_name, options);
+        for (int i = first_file; i < argc; ++i) {
+            int res = complete_task_sharded(argv[i], options);
+            if (res != 0) return res;
         }
+        return 0;
+    }
+
+    /* Ввод-вывод через консоль */
+    if (console) {
+        return complete_task_by_file("", options);
+    }
 
-        /* Ввод-вывод через список файлов */
-        for (int i = 1; i < argc; ++i) {
-            int res = complete_task_by_file(argv[i]);
+    /* Ввод-вывод через список файлов */
+    if (first_file < argc) {
+        for (int i = first_file; i < argc; ++i) {
+            int res = complete_task_by_file(argv[i], options);
             if (res != 0) return res;
         }
         return 0;
     }
 
     /* Ввод-вывод через файл по умолчанию */
-    return complete_task_by_file(default_fin_name);
+    return complete_task_by_file(default_fin_name, options);
 }
 
 #else // TEST_MODE
@@ -172,6 +668,9 @@ int main(int argc, char* argv[])
 #include <algorithm>
 #include <set>
 #include <list>
+#include <chrono>
+
+#include "static_rules.h"
 
 int c_count = 0;
 int d_count = 0;
@@ -268,6 +767,194 @@ static inline int test_main()
     }
 #endif // 0
 
+#if 1
+    {
+        // кэш чистой функции: повторные вызовы с теми же аргументами не вычисляются
+        using TGraph = TAnnotatedGraph<float, asAll>;
+        using TRules = TRules<TGraph>;
+
+        int calls = 0;
+        TRules rules;
+        rules.RegFunc("slow", 2, [&calls](TRules::TRuleFuncArgs const& v) { ++calls; return v[0] * v[1]; }, true);
+        rules.ReadMainRules(getVert, 1, { "slow v 1 3", "slow v 1 3", "slow v 2 2" });
+
+        TGraph G;
+        G.AddVertexes(4);
+        G.vertex[0].attribute = 2;
+        rules.SetOn(G);
+        rules.SetOn(G);
+        auto stats = rules.MemoStats("slow");
+        std::cout << "v4 = " << G.vertex[3].attribute << ", calls " << calls << ", hits " << stats.hits << ", misses " << stats.misses << "\n" << std::endl;
+    }
+#endif // 0
+
+#if 1
+    {
+        // достижимость в обе стороны и источники значения элемента
+        using TGraph = TAnnotatedGraph<float, asAll>;
+        using TRules = TRules<TGraph>;
+
+        TGraph G;
+        G.AddVertexes(5);
+        G.AddEdge(0, 1);
+        G.AddEdge(1, 2);
+        G.AddEdge(3, 2);
+        TTraversal<TGraph> traversal(G);
+        std::vector<uint32_t> depth;
+        std::cout << "from v1:";
+        traversal.Reach({ 0 }, tdForward, &depth).for_each([&](size_t v) { std::cout << " v" << v + 1 << "(" << depth[v] << ")"; });
+        std::cout << "\nto v3:";
+        traversal.Reach({ 2 }, tdBackward).for_each([](size_t v) { std::cout << " v" << v + 1; });
+        std::cout << std::endl;
+
+        TRules rules;
+        rules.RegFunc("+", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] + v[1]; });
+        rules.ReadMainRules(getVert, 1, { "+ v 1 e 1", "+ v 2 5" });
+        std::cout << "v3 depends on:";
+        for (auto [type, idx] : rules.Sources(getVert, 2)) std::cout << ' ' << (type == getVert ? 'v' : 'e') << idx + 1;
+        std::cout << std::endl;
+
+        // модель, как в файле: правило есть у каждого элемента, входное значение - константа v1
+        TRules model;
+        model.RegFunc("+", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] + v[1]; });
+        model.ReadMainRules(getVert, 0, { "5", "+ v 1 2", "+ v 2 v 1" });
+        auto sources = model.Sources(getVert, 2);
+        bool expected = sources.size() == 1 and sources[0] == std::pair{ getVert, TRules::link_idx_t{ 0 } };
+        std::cout << "model v3 sources: " << (expected ? "v1" : "WRONG") << std::endl;
+
+        // после сортировки правила переставлены: правила-ссылки ищутся по линкерам, зависимые - по обратному индексу
+        model.GetReady();
+        sources = model.Sources(getVert, 2);
+        expected = sources.size() == 1 and sources[0] == std::pair{ getVert, TRules::link_idx_t{ 0 } };
+        std::cout << "prepared v3 sources: " << (expected ? "v1" : "WRONG") << "\nv1 dependents:";
+        for (auto [type, idx] : model.Dependents(getVert, 0)) std::cout << ' ' << (type == getVert ? 'v' : 'e') << idx + 1;
+        std::cout << "\nv3 dependents:";
+        for (auto [type, idx] : model.Dependents(getVert, 2)) std::cout << ' ' << (type == getVert ? 'v' : 'e') << idx + 1;
+        std::cout << "\n" << std::endl;
+    }
+#endif // 0
+
+#if 1
+    {
+        // одна подготовленная агент-функция на нескольких графах в нескольких потоках
+        using TGraph = TAnnotatedGraph<float, asAll>;
+        using TRules = TRules<TGraph>;
+
+        TRules rules;
+        rules.RegFunc("*", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] * v[1]; });
+        rules.ReadMainRules(getVert, 1, { "* v 1 v 1", "* v 2 v 1" });
+        TRules const& prepared = rules.GetReady();
+
+        std::vector<std::unique_ptr<TGraph>> graphs(8);
+        std::vector<TGraph*> batch;
+        for (size_t i = 0; i < graphs.size(); ++i) {
+            graphs[i] = std::make_unique<TGraph>();
+            graphs[i]->AddVertexes(3);
+            graphs[i]->vertex[0].attribute = static_cast<float>(i);
+            batch.push_back(graphs[i].get());
+        }
+        prepared.SetOnBatch(batch, 4);
+        std::cout << "v1^3:";
+        for (auto const& G : graphs) std::cout << ' ' << G->vertex[2].attribute;
+
+        // применение со своим буфером; подготовленные правила изменить нельзя
+        TGraph G;
+        G.AddVertexes(3);
+        G.vertex[0].attribute = 10;
+        TRules::TScratch scratch;
+        prepared.Evaluate(G, scratch);
+        std::cout << ", " << G.vertex[2].attribute;
+        try {
+            rules.ReadMainRules(getVert, 1, { "* v 1 v 1" });
+            std::cout << ", NOT FROZEN";
+        }
+        catch (const std::logic_error&) { std::cout << ", frozen"; }
+        std::cout << "\n" << std::endl;
+    }
+#endif // 0
+
+#if 1
+    {
+        // агент-функция, заданная при компиляции, против TRules::SetOn на том же графе
+        using namespace static_rules;
+        using TGraph = TAnnotatedGraph<float, asAll>;
+        using TRules = TRules<TGraph>;
+        using clock = std::chrono::steady_clock;
+
+        constexpr int repeat = 1000000;
+
+        constexpr TStaticRules static_func{
+            vert_rule<1>(5),
+            vert_rule<2>(v<1> + 2),
+            vert_rule<3>(min(v<2>, e<1>)),
+            edge_rule<1>(v<1> * 3),
+            edge_rule<2>(e<1> - v<3>),
+        };
+
+        TRules agent_func{};
+        agent_func.RegFunc("min", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] < v[1] ? v[0] : v[1]; });
+        agent_func.RegFunc("+", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] + v[1]; });
+        agent_func.RegFunc("-", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] - v[1]; });
+        agent_func.RegFunc("*", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] * v[1]; });
+        agent_func.ReadMainRules(getVert, 0, { "5", "+ v 1 2", "min v 2 e 1" });
+        agent_func.ReadMainRules(getEdge, 0, { "* v 1 3", "- e 1 v 3" });
+
+        TGraph G1, G2;
+        for (TGraph* G : { &G1, &G2 }) {
+            G->AddVertexes(3);
+            G->AddEdge(0, 1);
+            G->AddEdge(1, 2);
+        }
+
+        auto t0 = clock::now();
+        for (int i = 0; i < repeat; ++i) static_func.SetOn(G1);
+        auto t1 = clock::now();
+        for (int i = 0; i < repeat; ++i) agent_func.SetOn(G2);
+        auto t2 = clock::now();
+
+        bool same = true;
+        for (size_t i = 0; i < 3; ++i) same &= G1.vertex[i].attribute == G2.vertex[i].attribute;
+        for (size_t i = 0; i < 2; ++i) same &= G1.edge[i].attribute == G2.edge[i].attribute;
+
+        std::cout << (same ? "same" : "DIFFERENT") << " results\n";
+        std::cout << std::chrono::duration<double, std::milli>(t1 - t0).count() << "\tms TStaticRules::SetOn\n";
+        std::cout << std::chrono::duration<double, std::milli>(t2 - t1).count() << "\tms TRules::SetOn\n";
+        std::cout << std::endl;
+    }
+#endif // 0
+
+#if 1
+    {
+        // разбор правил пакетами конвейера (по 16384 строки): время растёт линейно с количеством строк
+        // при любом количестве потоков (фрагменты пакета не выделяют память под все номера элементов)
+        // Ускорение от потоков этот блок не показывает: на одном ядре 8 потоков медленнее одного
+        // (создание потоков и слияние фрагментов), сравнивать 1 и 8 потоков имеет смысл только на многоядерной машине.
+        using TGraph = TAnnotatedGraph<float, asAll, size_t, TVectorStorage, tsNone>;
+        using TRules = TRules<TGraph>;
+        using clock = std::chrono::steady_clock;
+
+        constexpr size_t batch = 16384;
+        for (size_t count : { size_t{ 1 } << 17, size_t{ 1 } << 18 }) {
+            std::vector<std::string> lines(count);
+            for (size_t i = 0; i < count; ++i) lines[i] = "+ v " + std::to_string((i * 7919) % count + 1) + " 1";
+
+            for (size_t threads : { 1, 8 }) {
+                TRules rules;
+                rules.RegFunc("+", 2, [](TRules::TRuleFuncArgs const& v) {return v[0] + v[1]; });
+                rules.SetSizes(count, 0);
+                auto t0 = clock::now();
+                for (size_t first = 0; first < count; first += batch) {
+                    std::vector<std::string> part(lines.begin() + first, lines.begin() + std::min(count, first + batch));
+                    rules.ReadMainRules(getVert, first, part, threads);
+                }
+                std::cout << std::chrono::duration<double, std::milli>(clock::now() - t0).count() << "\tms " << count << " lines, " << threads << " threads"
+                    << " (" << std::thread::hardware_concurrency() << " cores)\n";
+            }
+        }
+        std::cout << std::endl;
+    }
+#endif // 0
+
 #if 1
     {
         TAnnotatedGraph<T, asVert, i_t> G;
@@ -296,6 +983,23 @@ static inline int test_main()
     }
     std::cout << std::endl;
 
+    // размеры узла/ребра в зависимости от поддерживаемых списков смежности
+    {
+        TAnnotatedGraph<T, asVert, i_t, TVectorStorage, tsOut> G_out;
+        TAnnotatedGraph<T, asVert, i_t, TVectorStorage, tsNone> G_none;
+        G_out.AddVertexes(3);
+        G_out.AddEdge(0, 1);
+        G_out.AddEdge(0, 2);
+        G_out.TopSort();
+        G_none.AddVertexes(3);
+        G_none.AddEdge(0, 1);
+        std::cout << sizeof(decltype(G_out)::TVert) << "\tvert size (out)\n";
+        std::cout << sizeof(decltype(G_out)::TEdge) << "\tedge size (out)\n";
+        std::cout << sizeof(decltype(G_none)::TVert) << "\tvert size (none)\n";
+        std::cout << sizeof(decltype(G_none)::TEdge) << "\tedge size (none)\n";
+    }
+    std::cout << std::endl;
+
     MyClass::print();
     std::cout << std::endl;
 #endif // 0
@@ -9,14 +9,24 @@
 #include <unordered_map>
 #include <limits>
 #include <functional>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 
 #include "my_graph.h"
+#include "graph_traversal.h"
+#include "memo_cache.h"
+#include "work_stealing.h"
 #include "ritm_test_suppor.h"
 
 template <
     typename TTargetGraph_,
     std::unsigned_integral rules_idx_t_ = typename TTargetGraph_::idx_type,
-    std::unsigned_integral func_arg_idx_t_ = unsigned short
+    std::unsigned_integral func_arg_idx_t_ = unsigned short,
+    typename storage_policy_ = typename TTargetGraph_::storage_policy
 >
 class TRules {
 #ifdef TEST_MODE
@@ -28,16 +38,32 @@ public:
     using link_idx_t = TTargetGraph::idx_type; //     
     using rules_idx_t = rules_idx_t_; //      
     using func_arg_idx_t = func_arg_idx_t_; //      (: "min a b" - 2 )
+    using storage_policy = storage_policy_; //      
+
+    template <typename T>
+    using TArray = typename storage_policy::template array<T>;
 
     using TRuleFuncArgs = std::vector<value_type>;
     using TRuleFunc = std::function<value_type(TRuleFuncArgs const&)>;
+    using TIdResolver = std::function<link_idx_t(Graph_Elem_Type, uint64_t)>; //    -> 
     using TAttribute = TAttribute<value_type>;
 
 private:
 
     struct TRuleFuncSpec {
-        TRuleFunc func;
+        TRuleFunc func; //      ( )
         func_arg_idx_t arg_count{ 0 };
+        TRuleFunc var_func; //      ( )
+        func_arg_idx_t var_step{ 1 }; //   var_func    var_step
+        std::unique_ptr<TMemoCache<value_type>> memo; //   func (   )
+        std::unique_ptr<TMemoCache<value_type>> var_memo; //   var_func
+
+        //    ,   
+        value_type Call(bool variadic, TRuleFuncArgs const& args) const {
+            TRuleFunc const& f = variadic ? var_func : func;
+            TMemoCache<value_type>* cache = (variadic ? var_memo : memo).get();
+            return cache ? cache->Get(args, f) : f(args);
+        }
     };
 
     using TRuleFuncSpecMap = std::unordered_map<std::string, TRuleFuncSpec>;
@@ -49,6 +75,8 @@ private:
     //  " -"
     struct TRule {
         TRuleType rule_type{ rtNone }; //  
+        bool variadic{ false }; //  :  var_func
+        func_arg_idx_t arg_count{ 0 }; //  :  
         union {
             value_type value;
             link_idx_t idx;
@@ -70,23 +98,67 @@ private:
         {};
 
         //   
-        TRule(TRuleFuncSpec const* func_spec)
+        TRule(TRuleFuncSpec const* func_spec, func_arg_idx_t arg_count, bool variadic)
             : rule_type{ rtFunc }
+            , variadic{ variadic }
+            , arg_count{ arg_count }
             , func{ func_spec }
         {};
 
     };
 
+public:
+    //          -
+    // (  ,   -,  )
+    struct TScratch {
+        TArray<value_type> res{};
+        TRuleFuncArgs args{};
+    };
+
 private:
-    using TLinker = std::unordered_map<link_idx_t, rules_idx_t>;
-    using TRuleGraph = TAnnotatedGraph<TRule, asVert, rules_idx_t>;
+    using TRuleGraph = TAnnotatedGraph<TRule, asVert, rules_idx_t, storage_policy, tsOut>; //      
     using TRuleIterator = typename TRuleGraph::TIterator;
+    using TLinker = TArray<rules_idx_t>; //   ,   -  (BAD_IDX -  )
+    using TFragmentLinker = std::unordered_map<link_idx_t, rules_idx_t>; //  :    
+    //    : 32     (     )
+    using slot_idx_t = std::conditional_t<(sizeof(rules_idx_t) < sizeof(uint32_t)), rules_idx_t, uint32_t>;
+
+    static constexpr rules_idx_t const NO_RULE = TRuleGraph::BAD_IDX;
+    static constexpr size_t const parallel_chunk_min = 1024; //        
+    static constexpr size_t const memo_capacity = 1 << 16; //      
 
     TLinker vert_linker{}; //   (  ,   )
     TLinker edge_linker{}; //   (  ,   )
+    TFragmentLinker fragment_vert_linker{}; //   (   )
+    TFragmentLinker fragment_edge_linker{};
+    link_idx_t vert_count{ std::numeric_limits<link_idx_t>::max() }; //     (   - )
+    link_idx_t edge_count{ std::numeric_limits<link_idx_t>::max() }; //    
     TRuleFuncSpecMap functions_specification{}; //   (     )
     TRuleGraph rules{}; //  -
     bool ready = false; //   
+    TArray<slot_idx_t> slot{}; //       (  GetReady)
+    slot_idx_t slots_count{ 0 }; //    
+    TArray<rules_idx_t> users_first{}; //   (  GetReady): ,  
+    TArray<rules_idx_t> users{};       //  ri, - users[users_first[ri]] .. users[users_first[ri + 1] - 1]
+    TScratch scratch{}; //    (   SetOn)
+    TRules const* owner{ nullptr }; //    ( ,    )
+    TIdResolver id_resolver{}; //     ( -  ,  1)
+
+    struct fragment_tag {};
+
+    //      -  (    )
+    void CheckNotReady(char const* where) const {
+        if (ready) throw std::logic_error(std::string(where) + ": agent function is already prepared");
+    }
+
+    //     (  -   )
+    link_idx_t ElemCount(Graph_Elem_Type elem_type) const {
+        if (owner) return owner->ElemCount(elem_type);
+        return elem_type == getVert ? vert_count : edge_count;
+    }
+
+    //  :    
+    TRules(TRules const& owner, fragment_tag) : owner(&owner) {}
 
 private:
     //  /  ""
@@ -97,8 +169,8 @@ private:
 
     //    "" (   )
     // !   /
-    rules_idx_t Add_Function(TRuleFuncSpec const* func_spec) {
-        rules.AddVertex(func_spec);
+    rules_idx_t Add_Function(TRuleFuncSpec const* func_spec, func_arg_idx_t arg_count, bool variadic) {
+        rules.AddVertex(func_spec, arg_count, variadic);
         return rules.vertex.size() - 1;
     }
 
@@ -113,91 +185,309 @@ private:
 
     //  /  ""
     rules_idx_t Add_Link(Graph_Elem_Type elem_type, link_idx_t idx) {
-        TLinker& linker = (elem_type == getVert) ? vert_linker : edge_linker;
+        if (idx >= ElemCount(elem_type)) {
+            // idx + 1 -     ("v 0"  idx = BAD_IDX,  idx + 1 = 0)
+            throw std::runtime_error(std::string("Invalid reference: ") + (elem_type == getVert ? "v " : "e ") + std::to_string(static_cast<link_idx_t>(idx + 1)));
+        }
+
+        //      ,    - -
+        if (owner) {
+            auto [it, inserted] = ((elem_type == getVert) ? fragment_vert_linker : fragment_edge_linker).try_emplace(idx, NO_RULE);
+            if (inserted) {
+                rules.AddVertex(elem_type, idx);
+                it->second = rules.vertex.size() - 1;
+            }
+            return it->second;
+        }
 
-        //     
-        auto it = linker.find(idx);
+        TLinker& linker = (elem_type == getVert) ? vert_linker : edge_linker;
+        if (idx >= linker.size()) linker.resize(static_cast<size_t>(idx) + 1, NO_RULE);
 
-        //  ,   
-        if (it != linker.end()) return it->second;
+        //       ,   
+        if (linker[idx] != NO_RULE) return linker[idx];
 
         // ,    ""
         rules.AddVertex(elem_type, idx);
         //      ,    
         rules_idx_t ri = rules.vertex.size() - 1;
-        linker.insert({ idx, ri });
+        linker[idx] = ri;
         return ri;
     }
 
+    //   
+    struct TCacheHeader {
+        char magic[4]{ 'G', 'A', 'R', 'C' };
+        uint32_t version{ 1 };
+        uint64_t key{ 0 };
+        uint64_t functions{ 0 }; //   
+        uint64_t rules{ 0 }; //  
+        uint64_t edges{ 0 }; //  
+    };
+
+    //     (     )
+    struct TCachedRule {
+        uint8_t rule_type{ rtNone };
+        bool variadic{ false };
+        func_arg_idx_t arg_count{ 0 };
+        union {
+            value_type value;
+            link_idx_t idx;
+            uint64_t func{ 0 };
+        };
+    };
+
+    //      (    )
+    std::vector<std::pair<std::string, TRuleFuncSpec const*>> SortedFunctions() const {
+        TRuleFuncSpecMap const& specs = owner ? owner->functions_specification : functions_specification;
+        std::vector<std::pair<std::string, TRuleFuncSpec const*>> res;
+        for (auto const& [name, fs] : specs) res.emplace_back(name, &fs);
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    //     - (  )
+    void Merge(TRules& fragment) {
+        TRuleGraph& frules = fragment.rules;
+        std::vector<rules_idx_t> remap(frules.vertex.size());
+
+        for (rules_idx_t fi = 0; fi < frules.vertex.size(); ++fi) {
+            TRule const& r = frules.vertex[fi].attribute;
+            if (r.rule_type == rtVertLink or r.rule_type == rtEdgeLink) {
+                //              
+                remap[fi] = Add_Link(r.rule_type == rtVertLink ? getVert : getEdge, r.idx);
+            }
+            else {
+                rules.AddVertex(r);
+                remap[fi] = rules.vertex.size() - 1;
+            }
+        }
+
+        //      ,    ,
+        //     
+        for (rules_idx_t fe = 0; fe < frules.edge.size(); ++fe) {
+            rules.AddEdge(remap[frules.edge[fe].from], remap[frules.edge[fe].to]);
+        }
+    }
+
     //     
     rules_idx_t ReadRule(std::istringstream& IN) {
         std::string str;
         ReadValue(IN, str); //   
+        return ReadRule(str, IN);
+    }
 
+    //  ,     
+    rules_idx_t ReadRule(std::string const& str, std::istringstream& IN) {
         //       (  "v"  "e")
         if (str.size() == 1 and (str[0] == 'v' or str[0] == 'e')) {
             Graph_Elem_Type et = str[0] == 'v' ? getVert : getEdge;
+            if (IdResolver()) {
+                uint64_t id;
+                ReadValue(IN, id);
+                return Add_Link(et, IdResolver()(et, id));
+            }
             link_idx_t li;
             ReadValue(IN, li);
             return Add_Link(et, li - 1);
         }
         //   
         TRuleFuncSpec const* fs = FunctionsSpec(str);
-        if (fs) {
-            //      
-            bool args_all_value = true;
-            std::vector<rules_idx_t> arg_idxs(fs->arg_count);
-            for (func_arg_idx_t i = 0; i < fs->arg_count; ++i) {
-                arg_idxs[i] = ReadRule(IN);
-                args_all_value &= rules.vertex[arg_idxs[i]].attribute().rule_type == rtValue;
+        if (fs) return ReadFunction(fs, IN);
+
+        //   
+        value_type val;
+        std::stringstream(str) >> val;
+        return Add_Value(val);
+    }
+
+    //   
+    //  : "f a b" -   ,
+    //               "f ( a b ... )"  "f N a b ..." -   
+    //               ( -      )
+    rules_idx_t ReadFunction(TRuleFuncSpec const* fs, std::istringstream& IN) {
+        bool variadic = false;
+        bool delimited = false;
+        size_t arg_count = fs->arg_count;
+        std::string first; //      
+
+        if (fs->var_func and (!fs->func or fs->arg_count > 0)) {
+            ReadValue(IN, first);
+            if (first == "(") {
+                variadic = delimited = true;
+                first.clear();
+            }
+            else if (!fs->func) {
+                variadic = true;
+                std::istringstream count_str(first);
+                if (!(count_str >> arg_count) or !count_str.eof()) throw std::runtime_error("Invalid format");
+                first.clear();
             }
+        }
 
-            //    -  ,      
-            if (args_all_value) {
-                std::vector<value_type> args(fs->arg_count);
-                for (func_arg_idx_t i = 0; i < fs->arg_count; ++i) {
-                    args[i] = rules.vertex[arg_idxs[i]].attribute().value;
-                }
-                return Add_Value(fs->func(args));
+        //      
+        bool args_all_value = true;
+        std::vector<rules_idx_t> arg_idxs;
+        auto read_arg = [&](std::string const& str) {
+            arg_idxs.push_back(ReadRule(str, IN));
+            args_all_value &= rules.vertex[arg_idxs.back()].attribute.rule_type == rtValue;
+        };
+        if (delimited) {
+            std::string str;
+            while (ReadValue(IN, str), str != ")") read_arg(str);
+        }
+        else {
+            arg_idxs.reserve(arg_count);
+            for (size_t i = 0; i < arg_count; ++i) {
+                if (first.empty()) ReadValue(IN, first);
+                read_arg(first);
+                first.clear();
             }
+        }
 
-            // ,   -    
-            rules_idx_t ri = Add_Function(fs);
-            for (func_arg_idx_t i = fs->arg_count; i > 0 ; --i) {
-                //     ,
-                //         
-                rules.AddEdge(ri, arg_idxs[i-1]);
+        if (variadic and (arg_idxs.empty() or arg_idxs.size() % fs->var_step != 0
+            or arg_idxs.size() > std::numeric_limits<func_arg_idx_t>::max())) {
+            throw std::runtime_error("Invalid argument count: " + std::to_string(arg_idxs.size()));
+        }
+        //    -  ,      
+        if (args_all_value) {
+            TRuleFuncArgs args(arg_idxs.size());
+            for (size_t i = 0; i < arg_idxs.size(); ++i) {
+                args[i] = rules.vertex[arg_idxs[i]].attribute.value;
             }
-            return ri;
+            return Add_Value(fs->Call(variadic, args));
         }
 
-        //   
-        value_type val;
-        std::stringstream(str) >> val;
-        return Add_Value(val);
+        // ,   -    
+        rules_idx_t ri = Add_Function(fs, static_cast<func_arg_idx_t>(arg_idxs.size()), variadic);
+        for (size_t i = arg_idxs.size(); i > 0 ; --i) {
+            //     ,
+            //         
+            rules.AddEdge(ri, arg_idxs[i-1]);
+        }
+        return ri;
+    }
+
+    static constexpr size_t const simd_lanes = 8; //     
+
+    //     (     )
+    template <typename TOp>
+    static value_type Reduce(value_type const* p, size_t n, TOp op) {
+        if (n < 2 * simd_lanes) {
+            value_type acc = p[0];
+            for (size_t i = 1; i < n; ++i) acc = op(acc, p[i]);
+            return acc;
+        }
+
+        value_type acc[simd_lanes];
+        for (size_t j = 0; j < simd_lanes; ++j) acc[j] = p[j];
+
+        size_t i = simd_lanes;
+        for (; i + simd_lanes <= n; i += simd_lanes) {
+            for (size_t j = 0; j < simd_lanes; ++j) acc[j] = op(acc[j], p[i + j]);
+        }
+        for (size_t w = simd_lanes / 2; w > 0; w /= 2) {
+            for (size_t j = 0; j < w; ++j) acc[j] = op(acc[j], acc[j + w]);
+        }
+        for (; i < n; ++i) acc[0] = op(acc[0], p[i]);
+        return acc[0];
+    }
+
+    //       
+    static value_type Dot(value_type const* a, value_type const* b, size_t n) {
+        value_type acc[simd_lanes]{};
+
+        size_t i = 0;
+        for (; i + simd_lanes <= n; i += simd_lanes) {
+            for (size_t j = 0; j < simd_lanes; ++j) acc[j] += a[i + j] * b[i + j];
+        }
+        for (; i < n; ++i) acc[0] += a[i] * b[i];
+        return Reduce(acc, simd_lanes, std::plus<>{});
     }
 
 public:
 
+    TRules() = default;
+
     //   
-    void RegFunc(std::string name, func_arg_idx_t arg_count, TRuleFunc const& func) {
-        //  "v"  "e"   
-        if (name == "v" or name == "e") throw std::runtime_error("Invalid function name: \"" + name + "\"");
+    // pure -   (    ),   
+    void RegFunc(std::string name, func_arg_idx_t arg_count, TRuleFunc const& func, bool pure = false) {
+        CheckNotReady("RegFunc");
+        //  "v"  "e"   , "("  ")" -   
+        if (name == "v" or name == "e" or name == "(" or name == ")") throw std::runtime_error("Invalid function name: \"" + name + "\"");
 
         TRuleFuncSpec& rfs = functions_specification[name];
         rfs.func = func;
         rfs.arg_count = arg_count;
+        rfs.memo = pure ? std::make_unique<TMemoCache<value_type>>(memo_capacity) : nullptr;
+    }
+
+    //       ( var_step)
+    //         ,   - "name ( ... )"
+    void RegVarFunc(std::string name, TRuleFunc const& func, func_arg_idx_t var_step = 1, bool pure = false) {
+        CheckNotReady("RegVarFunc");
+        //  "v", "e", "("  ")" 
+        if (name == "v" or name == "e" or name == "(" or name == ")") throw std::runtime_error("Invalid function name: \"" + name + "\"");
+        if (var_step == 0) throw std::runtime_error("Invalid argument count step for function: \"" + name + "\"");
+
+        TRuleFuncSpec& rfs = functions_specification[name];
+        rfs.var_func = func;
+        rfs.var_step = var_step;
+        rfs.var_memo = pure ? std::make_unique<TMemoCache<value_type>>(memo_capacity) : nullptr;
+    }
+
+    //    (      )
+    TMemoStats MemoStats(std::string name) const {
+        TMemoStats res;
+        TRuleFuncSpec const* fs = FunctionsSpec(name);
+        if (!fs) return res;
+        for (auto const* cache : { fs->memo.get(), fs->var_memo.get() }) {
+            if (!cache) continue;
+            res.hits += cache->Stats().hits;
+            res.misses += cache->Stats().misses;
+        }
+        return res;
+    }
+
+    //   : sum, min, max, mean  dot (dot a1 .. an b1 .. bn)
+    void RegReductions() {
+        RegVarFunc("sum", [](TRuleFuncArgs const& v) { return Reduce(v.data(), v.size(), std::plus<>{}); });
+        RegVarFunc("min", [](TRuleFuncArgs const& v) { return Reduce(v.data(), v.size(), [](value_type a, value_type b) { return a < b ? a : b; }); });
+        RegVarFunc("max", [](TRuleFuncArgs const& v) { return Reduce(v.data(), v.size(), [](value_type a, value_type b) { return a > b ? a : b; }); });
+        RegVarFunc("mean", [](TRuleFuncArgs const& v) { return Reduce(v.data(), v.size(), std::plus<>{}) / static_cast<value_type>(v.size()); });
+        RegVarFunc("dot", [](TRuleFuncArgs const& v) { return Dot(v.data(), v.data() + v.size() / 2, v.size() / 2); }, 2);
     }
 
     //       
     TRuleFuncSpec const* FunctionsSpec(std::string name) const {
+        if (owner) return owner->FunctionsSpec(name);
         auto it = functions_specification.find(name);
         return (it == functions_specification.end()) ? nullptr : &(it->second);
     }
 
+    //   :  "v <>"/"e <>"   resolver,
+    //         
+    void SetIdResolver(TIdResolver resolver) { id_resolver = std::move(resolver); }
+
+    TIdResolver const& IdResolver() const { return owner ? owner->IdResolver() : id_resolver; }
+
+    //   :     [1, verts] / [1, edges]   
+    // (     )
+    void SetSizes(link_idx_t verts, link_idx_t edges) {
+        vert_count = verts;
+        edge_count = edges;
+        if (vert_linker.size() < verts) vert_linker.resize(verts, NO_RULE);
+        if (edge_linker.size() < edges) edge_linker.resize(edges, NO_RULE);
+    }
+
     //     -
     rules_idx_t ReadMainRule(Graph_Elem_Type elem_type, link_idx_t idx, std::istringstream& IN) {
-        ready = false;
+        CheckNotReady("ReadMainRule");
+
+        if (IdResolver()) {
+            uint64_t id;
+            ReadValue(IN, id);
+            if (IdResolver()(elem_type, id) != idx) throw std::runtime_error("Element id " + std::to_string(id) + " is out of order");
+        }
 
         rules_idx_t li = Add_Link(elem_type, idx);
         rules_idx_t ri = ReadRule(IN);
@@ -205,39 +495,415 @@ public:
         return li;
     }
 
-    //  -     ( )
-    void GetReady() {
+    //      -   first_idx, first_idx + 1, ...
+    //    ,     ,   
+    //    ELine     
+    void ReadMainRules(Graph_Elem_Type elem_type, link_idx_t first_idx, std::vector<std::string> const& lines, size_t threads = 0) {
+        CheckNotReady("ReadMainRules");
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunks = std::clamp<size_t>(lines.size() / parallel_chunk_min, 1, threads);
+        size_t chunk_size = (lines.size() + chunks - 1) / chunks;
+
+        TLinker& linker = (elem_type == getVert) ? vert_linker : edge_linker;
+        size_t last_idx = std::min<size_t>(static_cast<size_t>(first_idx) + lines.size(), ElemCount(elem_type));
+        if (last_idx > linker.size()) linker.resize(last_idx, NO_RULE);
+
+        //    [begin, end)   dest
+        //      (lines.size() -   )
+        auto parse = [&](TRules& dest, size_t begin, size_t end, std::string& error) -> size_t {
+            for (size_t i = begin; i < end; ++i) {
+                try {
+                    std::istringstream str(lines[i]);
+                    dest.ReadMainRule(elem_type, first_idx + static_cast<link_idx_t>(i), str);
+                }
+                catch (const std::exception& exc) {
+                    error = exc.what();
+                    return i;
+                }
+            }
+            return lines.size();
+        };
+
+        if (chunks == 1) {
+            std::string error;
+            size_t bad = parse(*this, 0, lines.size(), error);
+            if (bad < lines.size()) throw ELine(error, bad);
+            return;
+        }
+
+        std::vector<std::unique_ptr<TRules>> fragments; //     (viewer'    )
+        std::vector<size_t> bad(chunks, lines.size());
+        std::vector<std::string> errors(chunks);
+        fragments.reserve(chunks);
+        for (size_t c = 0; c < chunks; ++c) fragments.emplace_back(new TRules(*this, fragment_tag{}));
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(chunks);
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t begin = std::min(c * chunk_size, lines.size());
+                size_t end = std::min(begin + chunk_size, lines.size());
+                workers.emplace_back([&, c, begin, end] { bad[c] = parse(*fragments[c], begin, end, errors[c]); });
+            }
+        }
+
+        //     (    )
+        for (size_t c = 0; c < chunks; ++c) {
+            if (bad[c] < lines.size()) throw ELine(errors[c], bad[c]);
+        }
+
+        for (auto& fragment : fragments) Merge(*fragment);
+    }
+
+    //     (count ),    
+    // -        
+    std::vector<bool> Computed(Graph_Elem_Type elem_type, size_t count) const {
+        std::vector<bool> mask(count, false);
+        TRuleType link_type = elem_type == getVert ? rtVertLink : rtEdgeLink;
+        for (rules_idx_t ri = 0; ri < rules.vertex.size(); ++ri) {
+            TRule const& r = rules.vertex[ri].attribute;
+            if (r.rule_type != link_type or r.idx >= count) continue;
+            TRuleIterator iter{ rules, ri };
+            if (!iter.end_e()) mask[r.idx] = rules.vertex[iter.look_e()].attribute.rule_type != rtValue;
+        }
+        return mask;
+    }
+
+    //   ,        idx
+    //   -  ,   -  (  Computed),     
+    // (    ). -    ;  -      .
+    std::vector<std::pair<Graph_Elem_Type, link_idx_t>> Sources(Graph_Elem_Type elem_type, link_idx_t idx, size_t threads = 0) const {
+        std::vector<std::pair<Graph_Elem_Type, link_idx_t>> res;
+
+        rules_idx_t start = LinkRule(elem_type, idx);
+        if (start == NO_RULE) return res;
+
+        //    ,         
+        // (       -)
+        TTraversal<TRuleGraph>(rules, threads).Reach({ start }).for_each([&](size_t ri) {
+            TRule const& r = rules.vertex[ri].attribute;
+            if (r.rule_type != rtVertLink and r.rule_type != rtEdgeLink) return;
+            TRuleIterator iter{ rules, static_cast<rules_idx_t>(ri) };
+            if (iter.end_e() or rules.vertex[iter.look_e()].attribute.rule_type == rtValue) {
+                res.emplace_back(r.rule_type == rtVertLink ? getVert : getEdge, r.idx);
+            }
+        });
+        return res;
+    }
+
+    //   ,       idx (,  Sources)
+    //      ,      ,   GetReady.
+    //  -     .
+    std::vector<std::pair<Graph_Elem_Type, link_idx_t>> Dependents(Graph_Elem_Type elem_type, link_idx_t idx) const {
+        if (!ready) throw std::logic_error("Dependents: agent function is not ready");
+        std::vector<std::pair<Graph_Elem_Type, link_idx_t>> res;
+
+        rules_idx_t start = LinkRule(elem_type, idx);
+        if (start == NO_RULE) return res;
+
+        TBitset visited(rules.vertex.size());
+        std::vector<rules_idx_t> stack{ start };
+        visited.set(start);
+        while (!stack.empty()) {
+            rules_idx_t ri = stack.back();
+            stack.pop_back();
+            for (rules_idx_t u = users_first[ri]; u < users_first[ri + 1]; ++u) {
+                if (visited.test(users[u])) continue;
+                visited.set(users[u]);
+                stack.push_back(users[u]);
+            }
+        }
+
+        //    ,   (  )
+        visited.for_each([&](size_t ri) {
+            TRule const& r = rules.vertex[ri].attribute;
+            if (ri == start or (r.rule_type != rtVertLink and r.rule_type != rtEdgeLink)) return;
+            res.emplace_back(r.rule_type == rtVertLink ? getVert : getEdge, r.idx);
+        });
+        return res;
+    }
+
+private:
+    // -     (NO_RULE -      )
+    rules_idx_t LinkRule(Graph_Elem_Type elem_type, link_idx_t idx) const {
+        TLinker const& linker = (elem_type == getVert) ? vert_linker : edge_linker;
+        return idx < linker.size() ? linker[idx] : NO_RULE;
+    }
+
+    //        (     ):
+    //     -,    ,   .
+    //    GetReady  LoadCache  ,  AllocateSlots.
+    void IndexRules() {
+        CheckNotReady("IndexRules");
+        rules_idx_t count = rules.vertex.size();
+
+        std::fill(vert_linker.begin(), vert_linker.end(), NO_RULE);
+        std::fill(edge_linker.begin(), edge_linker.end(), NO_RULE);
+        users_first = TArray<rules_idx_t>(static_cast<size_t>(count) + 1, 0);
+        for (rules_idx_t ri = 0; ri < count; ++ri) {
+            TRule const& r = rules.vertex[ri].attribute;
+            if (r.rule_type == rtVertLink or r.rule_type == rtEdgeLink) {
+                TLinker& linker = (r.rule_type == rtVertLink) ? vert_linker : edge_linker;
+                if (r.idx >= linker.size()) linker.resize(static_cast<size_t>(r.idx) + 1, NO_RULE);
+                linker[r.idx] = ri;
+            }
+            for (TRuleIterator iter{ rules, ri }; !iter.end_e(); iter.next_e()) ++users_first[iter.look_e()];
+        }
+
+        // users_first[ri] -   ri,     ,  users_first[ri]  
+        for (rules_idx_t ri = 0; ri < count; ++ri) users_first[ri + 1] += users_first[ri];
+        users = TArray<rules_idx_t>(users_first[count]);
+        for (rules_idx_t ri = 0; ri < count; ++ri) {
+            for (TRuleIterator iter{ rules, ri }; !iter.end_e(); iter.next_e()) users[--users_first[iter.look_e()]] = ri;
+        }
+    }
+
+    //       (  )
+    //         ,   ,
+    //      .     .
+    //    GetReady  LoadCache  :      .
+    void AllocateSlots() {
+        CheckNotReady("AllocateSlots");
+        rules_idx_t count = rules.vertex.size();
+
+        //  ,   (NO_RULE -    )
+        TArray<rules_idx_t> last_use(count, NO_RULE);
+        for (rules_idx_t ri = 0; ri < count; ++ri) {
+            for (TRuleIterator iter{ rules, ri }; !iter.end_e(); iter.next_e()) last_use[iter.look_e()] = ri;
+        }
+
+        slot = TArray<slot_idx_t>(count);
+        slots_count = 0;
+        std::vector<slot_idx_t> free_slots;
+        for (rules_idx_t ri = 0; ri < count; ++ri) {
+            //     ,        
+            for (TRuleIterator iter{ rules, ri }; !iter.end_e(); iter.next_e()) {
+                rules_idx_t arg = iter.look_e();
+                if (last_use[arg] != ri) continue;
+                last_use[arg] = NO_RULE; //   
+                free_slots.push_back(slot[arg]);
+            }
+
+            if (free_slots.empty()) {
+                if (slots_count == std::numeric_limits<slot_idx_t>::max()) throw std::runtime_error("Too many intermediate results");
+                slot[ri] = slots_count++;
+            }
+            else {
+                slot[ri] = free_slots.back();
+                free_slots.pop_back();
+            }
+
+            if (last_use[ri] == NO_RULE) free_slots.push_back(slot[ri]);
+        }
+
+        //          
+        rules.Advise(aaSequential);
+        StorageAdvise(slot, aaSequential);
+    }
+
+public:
+    //  -     (     )
+    //   -   :  Evaluate/SetOnBatch    
+    //       .      :
+    // ReadMainRule(s), RegFunc, RegVarFunc  LoadCache  std::logic_error,  GetReady   .
+    TRules const& GetReady() {
+        if (ready) return *this;
         rules.TopSort();
+        IndexRules();
+        AllocateSlots();
+        ready = true;
+        return *this;
     }
 
-    //  -  
-    void SetOn(TTargetGraph& graph) {
-        if (!ready) {
-            rules.TopSort();
-            ready = true;
+    //   -
+
+    //  :        
+    // (     ,      ,    )
+    // numbering -   ,      (,    )
+    uint64_t CacheKey(std::vector<std::string> const& vert_lines, std::vector<std::string> const& edge_lines, uint64_t numbering = 0) const {
+        THash h;
+        h.add(std::string_view(__DATE__ " " __TIME__));
+        h.add(numbering);
+        h.add<uint8_t>(sizeof(value_type)).add<uint8_t>(sizeof(link_idx_t)).add<uint8_t>(sizeof(rules_idx_t)).add<uint8_t>(sizeof(func_arg_idx_t));
+
+        for (auto const& [name, fs] : SortedFunctions()) {
+            h.add(name).add(static_cast<bool>(fs->func)).add(fs->arg_count).add(static_cast<bool>(fs->var_func)).add(fs->var_step);
+        }
+
+        //      
+        for (auto const* lines : { &vert_lines, &edge_lines }) {
+            h.add<uint64_t>(lines->size());
+            for (auto const& line : *lines) {
+                std::istringstream str(line);
+                for (std::string word; str >> word; ) h.add(word);
+                h.add<uint8_t>('\n');
+            }
+        }
+        return h.value;
+    }
+
+    //       
+    void SaveCache(std::filesystem::path const& file, uint64_t key) const {
+        if (!ready) throw std::logic_error("SaveCache: agent function is not ready");
+
+        auto functions = SortedFunctions();
+        std::unordered_map<TRuleFuncSpec const*, uint64_t> func_idx;
+        for (auto const& [name, fs] : functions) func_idx.emplace(fs, func_idx.size());
+
+        //      ,       
+        // (       ,       )
+        std::filesystem::path tmp = file;
+        tmp += ".tmp" + std::to_string(CurrentProcessId())
+            + "_" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (out.fail()) throw std::runtime_error("   : \"" + tmp.string() + "\"");
+            auto put = [&out](auto const& val) { out.write(reinterpret_cast<char const*>(&val), sizeof(val)); };
+
+            TCacheHeader header{ .key = key, .functions = functions.size(), .rules = rules.vertex.size(), .edges = rules.edge.size() };
+            put(header);
+            for (auto const& [name, fs] : functions) {
+                put(static_cast<uint64_t>(name.size()));
+                out.write(name.data(), name.size());
+            }
+            for (rules_idx_t ri = 0; ri < rules.vertex.size(); ++ri) {
+                TRule const& r = rules.vertex[ri].attribute;
+                TCachedRule cr{};
+                cr.rule_type = static_cast<uint8_t>(r.rule_type);
+                cr.variadic = r.variadic;
+                cr.arg_count = r.arg_count;
+                if (r.rule_type == rtValue) cr.value = r.value;
+                else if (r.rule_type == rtFunc) cr.func = func_idx.at(r.func);
+                else cr.idx = r.idx;
+                put(cr);
+            }
+            for (rules_idx_t e = 0; e < rules.edge.size(); ++e) {
+                put(rules.edge[e].from);
+                put(rules.edge[e].to);
+            }
+            if (out.fail()) throw std::runtime_error("   : \"" + tmp.string() + "\"");
         }
+        std::filesystem::rename(tmp, file);
+    }
 
-        std::vector<value_type> res(rules.vertex.size());
+    //        (   )
+    //  false,        /  
+    bool LoadCache(std::filesystem::path const& file, uint64_t key) {
+        CheckNotReady("LoadCache");
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(file, ec)) return false;
+
+        TMappedFile map(file);
+        char const* p = static_cast<char const*>(map.data());
+        char const* end = p + map.size();
+        auto get = [&p, end](auto& val) {
+            if (static_cast<size_t>(end - p) < sizeof(val)) return false;
+            std::memcpy(&val, p, sizeof(val));
+            p += sizeof(val);
+            return true;
+        };
+
+        TCacheHeader header;
+        if (!get(header) or std::memcmp(header.magic, TCacheHeader{}.magic, sizeof(header.magic)) != 0
+            or header.version != TCacheHeader{}.version or header.key != key) return false;
+
+        std::vector<TRuleFuncSpec const*> functions(header.functions);
+        for (auto& fs : functions) {
+            uint64_t len;
+            if (!get(len) or static_cast<uint64_t>(end - p) < len) return false;
+            fs = FunctionsSpec(std::string(p, len));
+            if (!fs) return false;
+            p += len;
+        }
+        uint64_t left = static_cast<uint64_t>(end - p);
+        if (header.rules > left / sizeof(TCachedRule) or header.edges > left / (2 * sizeof(rules_idx_t))
+            or left != header.rules * sizeof(TCachedRule) + header.edges * 2 * sizeof(rules_idx_t)) return false;
+
+        TRuleGraph loaded;
+        std::vector<uint64_t> out_degree(header.rules, 0);
+        for (uint64_t ri = 0; ri < header.rules; ++ri) {
+            TCachedRule cr{};
+            if (!get(cr)) return false;
+            switch (cr.rule_type) {
+            case rtValue   : loaded.AddVertex(cr.value); break;
+            //    ,     (    )
+            case rtVertLink:
+                if (cr.idx >= ElemCount(getVert)) return false;
+                loaded.AddVertex(getVert, cr.idx);
+                break;
+            case rtEdgeLink:
+                if (cr.idx >= ElemCount(getEdge)) return false;
+                loaded.AddVertex(getEdge, cr.idx);
+                break;
+            case rtFunc    : {
+                if (cr.func >= functions.size()) return false;
+                //       (   )
+                TRuleFuncSpec const* fs = functions[cr.func];
+                bool const valid = cr.variadic
+                    ? fs->var_func and cr.arg_count > 0 and cr.arg_count % fs->var_step == 0
+                    : fs->func and cr.arg_count == fs->arg_count;
+                if (!valid) return false;
+                loaded.AddVertex(fs, cr.arg_count, cr.variadic);
+                break;
+            }
+            default: return false;
+            }
+        }
+        //     ,    (  )  
+        for (uint64_t e = 0; e < header.edges; ++e) {
+            rules_idx_t from{}, to{};
+            if (!get(from) or !get(to)) return false;
+            if (from >= header.rules or to >= header.rules) return false;
+            //    :      
+            if (to >= from) return false;
+            ++out_degree[from];
+            loaded.AddEdge(from, to);
+        }
+        //    arg_count ,   -    ,   -  
+        for (uint64_t ri = 0; ri < header.rules; ++ri) {
+            TRule const& r = loaded.vertex[ri].attribute;
+            bool const valid = r.rule_type == rtFunc  ? out_degree[ri] == r.arg_count
+                             : r.rule_type == rtValue ? out_degree[ri] == 0
+                             :                          out_degree[ri] <= 1;
+            if (!valid) return false;
+        }
+
+        rules.Swap(loaded);
+        IndexRules();
+        AllocateSlots();
+        ready = true;
+        return true;
+    }
+
+    //   -     
+    // (  -,            )
+    void Evaluate(TTargetGraph& graph, TScratch& scratch) const {
+        if (!ready) throw std::logic_error("Evaluate: agent function is not ready");
+
+        //   -   ,    GetReady()
+        if (scratch.res.size() < slots_count) scratch.res.resize(slots_count);
+        TArray<value_type>& res = scratch.res;
+        TRuleFuncArgs& args = scratch.args; //  ,    -
 
         //     
         for (rules_idx_t ri = 0; ri < rules.vertex.size(); ++ri) {
             TRuleIterator iter{ rules, ri };
-            TRule& r = rules.vertex[ri].attribute();
+            TRule const& r = rules.vertex[ri].attribute;
 
             //   -  
             if (r.rule_type == rtValue) {
-                res[ri] = r.value; //  
+                res[slot[ri]] = r.value; //  
                 continue;
             }
 
             //   -    
             if (r.rule_type == rtVertLink) {
                 if (iter.end_e()) { //       
-                    res[ri] = graph.vertex[r.idx].attribute; //     
+                    res[slot[ri]] = graph.vertex[r.idx].attribute; //     
                 }
                 else { // 
-                    res[ri] = res[iter.look_e()]; //  ,    
-                    graph.vertex[r.idx].attribute = res[ri]; //       
+                    res[slot[ri]] = res[slot[iter.look_e()]]; //  ,    
+                    graph.vertex[r.idx].attribute = res[slot[ri]]; //       
                 }
                 continue;
             }
@@ -245,25 +911,44 @@ public:
             //       
             if (r.rule_type == rtEdgeLink) {
                 if (iter.end_e()) {
-                    res[ri] = graph.edge[r.idx].attribute;
+                    res[slot[ri]] = graph.edge[r.idx].attribute;
                 }
                 else {
-                    res[ri] = res[iter.look_e()];
-                    graph.edge[r.idx].attribute = res[ri];
+                    res[slot[ri]] = res[slot[iter.look_e()]];
+                    graph.edge[r.idx].attribute = res[slot[ri]];
                 }
                 continue;
             }
 
             //   -  
             //if (r.rule_type == rtFunc) {
-                std::vector<value_type> args(r.func->arg_count);
+                args.resize(r.arg_count);
                 for (func_arg_idx_t i = 0; i < args.size(); ++i) { //        
-                    args[i] = res[iter.look_e()]; //  
+                    args[i] = res[slot[iter.look_e()]]; //  
                     iter.next_e(); //  
                 }
-                res[ri] = r.func->func(args); //     
+                res[slot[ri]] = r.func->Call(r.variadic, args); //   (   )   
             //    continue;
             //}
         }
     }
+
+    //  -  
+    // (  -   ,     - Evaluate   )
+    void SetOn(TTargetGraph& graph) {
+        if (!ready) GetReady();
+        Evaluate(graph, scratch);
+    }
+
+    //   -     threads  (0 -    )
+    //       ,       .
+    void SetOnBatch(std::vector<TTargetGraph*> const& graphs, size_t threads = 0) const {
+        if (!ready) throw std::logic_error("SetOnBatch: agent function is not ready");
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<TScratch> scratches(std::min(threads, graphs.size()));
+        WorkStealingFor(graphs.size(), threads, [&](size_t i, size_t worker) {
+            Evaluate(*graphs[i], scratches[worker]);
+        });
+    }
 };
@@ -0,0 +1,158 @@
+/* ******************************************************************************************************** */
+/*                            ͨ  ()                                      */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <limits>
+#include <string_view>
+
+#include "my_graph.h"
+#include "ritm_test_suppor.h"
+
+//  :
+//    -   "delta <NV> <NE> < >",   "v <> <>" / "e <> <>"
+//               ( ,     ,   1);
+//     - "GARD",   (1 ), NV, NE,  ,   ( 8 ),
+//                :  (8 ,   * 2 + 1  ,   0)  .
+//    (  -  )    ,     
+//    .       ,     
+//       .
+
+enum TOutputMode { omFull = 0, omDeltaText, omDeltaBinary };
+
+constexpr char const delta_magic[4] = { 'G', 'A', 'R', 'D' };
+
+//       line (  0)      
+inline void DeltaCheckAdd(THash& check, uint64_t line, std::string_view text) { check.add(line).add(text); }
+
+//        
+template <typename TGraph>
+void WriteDelta(std::ostream& OUT, TOutputMode mode, TGraph& graph, std::vector<bool> const& v_mask, std::vector<bool> const& e_mask) {
+    using value_type = typename TGraph::attr_value_type;
+
+    uint64_t NV = v_mask.size();
+    uint64_t NE = e_mask.size();
+
+    //       (   ,    )
+    THash check;
+    std::ostringstream str;
+    auto add_input = [&](uint64_t line, value_type val) {
+        str.str({});
+        str << val;
+        DeltaCheckAdd(check, line, str.view());
+    };
+    for (uint64_t i = 0; i < NV; ++i) if (!v_mask[i]) add_input(i, graph.vertex[i].attribute);
+    for (uint64_t i = 0; i < NE; ++i) if (!e_mask[i]) add_input(NV + i, graph.edge[i].attribute);
+
+    if (mode == omDeltaText) {
+        OUT << "delta " << NV << ' ' << NE << ' ' << check.value << '\n';
+        for (uint64_t i = 0; i < NV; ++i) if (v_mask[i]) OUT << "v " << i + 1 << ' ' << graph.vertex[i].attribute << '\n';
+        for (uint64_t i = 0; i < NE; ++i) if (e_mask[i]) OUT << "e " << i + 1 << ' ' << graph.edge[i].attribute << '\n';
+        return;
+    }
+
+    auto put = [&OUT](auto const& val) { OUT.write(reinterpret_cast<char const*>(&val), sizeof(val)); };
+
+    uint64_t count = 0;
+    for (bool f : v_mask) count += f;
+    for (bool f : e_mask) count += f;
+
+    OUT.write(delta_magic, sizeof(delta_magic));
+    put(static_cast<uint8_t>(sizeof(value_type)));
+    put(NV);
+    put(NE);
+    put(check.value);
+    put(count);
+    for (uint64_t i = 0; i < NV; ++i) if (v_mask[i]) { put(i * 2    ); put(static_cast<value_type>(graph.vertex[i].attribute)); }
+    for (uint64_t i = 0; i < NE; ++i) if (e_mask[i]) { put(i * 2 + 1); put(static_cast<value_type>(graph.edge[i].attribute)); }
+}
+
+//   (  )   
+// base -   (NV + NE ),     OUT
+template <typename value_type>
+void MergeDelta(std::istream& base, std::istream& delta, std::ostream& OUT) {
+    uint64_t NV, NE, check;
+    std::vector<std::pair<uint64_t, value_type>> records; // (   , )
+
+    char magic[sizeof(delta_magic)]{};
+    delta.read(magic, sizeof(magic));
+    if (delta and std::memcmp(magic, delta_magic, sizeof(magic)) == 0) {
+        auto get = [&delta](auto& val) {
+            delta.read(reinterpret_cast<char*>(&val), sizeof(val));
+            if (!delta) throw std::runtime_error("Unexpected end of delta");
+        };
+        uint8_t value_size;
+        uint64_t count;
+        get(value_size);
+        if (value_size != sizeof(value_type)) throw std::runtime_error("Delta value size mismatch");
+        get(NV);
+        get(NE);
+        get(check);
+        get(count);
+
+        //              
+        uint64_t const record_size = sizeof(uint64_t) + sizeof(value_type);
+        std::streampos pos = delta.tellg();
+        delta.seekg(0, std::ios::end);
+        std::streampos end = delta.tellg();
+        delta.seekg(pos);
+        if (NV > std::numeric_limits<uint64_t>::max() - NE or count > NV + NE
+            or pos < 0 or end < pos or static_cast<uint64_t>(end - pos) % record_size != 0
+            or static_cast<uint64_t>(end - pos) / record_size != count) {
+            throw std::runtime_error("Delta is corrupted: record count does not match the file size");
+        }
+        records.resize(count);
+        for (auto& [line, val] : records) {
+            uint64_t key;
+            get(key);
+            get(val);
+            line = (key & 1) ? NV + key / 2 : key / 2;
+        }
+    }
+    else {
+        delta.clear();
+        delta.seekg(0);
+        std::string s_buf;
+        std::getline(delta, s_buf);
+        std::istringstream header(s_buf);
+        std::string word;
+        if (!(header >> word >> NV >> NE >> check) or word != "delta" or NV > std::numeric_limits<uint64_t>::max() - NE) throw std::runtime_error("Invalid delta header");
+        while (std::getline(delta, s_buf)) {
+            if (s_buf.empty()) continue;
+            std::istringstream rec(s_buf);
+            uint64_t idx;
+            value_type val;
+            if (!(rec >> word >> idx >> val) or (word != "v" and word != "e") or idx == 0) throw std::runtime_error("Invalid delta record: \"" + s_buf + "\"");
+            records.emplace_back(word == "v" ? idx - 1 : NV + idx - 1, val);
+        }
+    }
+
+    //     ,     ,    
+    std::vector<std::string> lines;
+    for (std::string line; lines.size() < NV + NE; lines.push_back(std::move(line))) {
+        if (!std::getline(base, line)) throw std::runtime_error("Base result is shorter than the delta header says");
+    }
+
+    std::vector<bool> in_delta(lines.size(), false);
+    for (auto const& [line, val] : records) {
+        if (line >= lines.size()) throw std::runtime_error("Delta record out of range");
+        in_delta[line] = true;
+    }
+    THash base_check;
+    for (uint64_t i = 0; i < lines.size(); ++i) if (!in_delta[i]) DeltaCheckAdd(base_check, i, lines[i]);
+    if (base_check.value != check) throw std::runtime_error("Base result does not match the delta: input values of the model have changed");
+
+    for (auto const& [line, val] : records) {
+        std::ostringstream str;
+        str << val;
+        lines[line] = str.str();
+    }
+    for (auto const& line : lines) OUT << line << '\n';
+}
@@ -0,0 +1,213 @@
+/* ******************************************************************************************************** */
+/*                                :                                      */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <bit>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "my_graph.h"
+
+//   (    )
+class TBitset {
+private:
+    std::vector<uint64_t> words;
+    size_t bits{ 0 };
+
+public:
+    static constexpr size_t const word_bits = 64;
+
+    TBitset() = default;
+    explicit TBitset(size_t size) : words((size + word_bits - 1) / word_bits, 0), bits(size) {}
+
+    size_t size() const { return bits; }
+    size_t words_count() const { return words.size(); }
+
+    uint64_t      & word(size_t i)       { return words[i]; }
+    uint64_t const& word(size_t i) const { return words[i]; }
+
+    //     (    )
+    uint64_t word_mask(size_t i) const {
+        size_t tail = bits - i * word_bits;
+        return tail >= word_bits ? ~uint64_t{ 0 } : (uint64_t{ 1 } << tail) - 1;
+    }
+
+    bool test(size_t i) const { return (words[i / word_bits] >> (i % word_bits)) & 1; }
+    void set(size_t i) { words[i / word_bits] |= uint64_t{ 1 } << (i % word_bits); }
+
+    //     ,  true,     
+    bool set_atomic(size_t i) {
+        uint64_t mask = uint64_t{ 1 } << (i % word_bits);
+        return !(std::atomic_ref<uint64_t>(words[i / word_bits]).fetch_or(mask, std::memory_order_relaxed) & mask);
+    }
+
+    void clear() { std::fill(words.begin(), words.end(), uint64_t{ 0 }); }
+
+    size_t count() const {
+        size_t res = 0;
+        for (uint64_t w : words) res += std::popcount(w);
+        return res;
+    }
+
+    //     
+    template <typename TFunc>
+    void for_each(TFunc&& func) const {
+        for (size_t i = 0; i < words.size(); ++i)
+            for (uint64_t w = words[i]; w; w &= w - 1) func(i * word_bits + std::countr_zero(w));
+    }
+};
+
+//  :   ( from  to)   
+enum TTraversalDirection { tdForward = 0, tdBackward };
+
+//           
+//  "push"        ,  "pull" -   
+//         .      ,  
+//    (pull -   ),   .      .
+template <typename TGraph>
+class TTraversal {
+public:
+    using idx_type = typename TGraph::idx_type;
+    static constexpr uint32_t const NO_DEPTH = std::numeric_limits<uint32_t>::max();
+
+private:
+    static constexpr bool const has_out = HasOutputs<TGraph::topology_spec>;
+    static constexpr bool const has_in  = HasInputs <TGraph::topology_spec>;
+    static_assert(has_out or has_in, "TTraversal: graph has no adjacency lists");
+
+    static constexpr size_t const alpha = 14; // push -> pull,    1/alpha  
+    static constexpr size_t const beta  = 24; // pull -> push,    1/beta  
+    static constexpr size_t const parallel_words_min = 1024; //       
+
+    TGraph const& graph;
+    size_t threads;
+
+    //   : out -    ( - to),    ( - from)
+    // func  true,   
+    template <bool out, typename TFunc>
+    void ForEachNeighbor(idx_type v, TFunc&& func) const {
+        if constexpr (out and has_out) {
+            for (idx_type e = graph.vertex[v].first_output; e != TGraph::BAD_IDX; e = graph.edge[e].next_from)
+                if (func(graph.edge[e].to)) return;
+        }
+        if constexpr (!out and has_in) {
+            for (idx_type e = graph.vertex[v].first_input; e != TGraph::BAD_IDX; e = graph.edge[e].next_to)
+                if (func(graph.edge[e].from)) return;
+        }
+    }
+
+    //   [0, words)    : func(first, last)    
+    template <typename TFunc>
+    size_t Parallel(size_t words, TFunc const& func) const {
+        size_t chunks = std::min(threads, std::max<size_t>(1, words / parallel_words_min));
+        if (chunks <= 1) return func(size_t{ 0 }, words);
+
+        std::atomic<size_t> total{ 0 };
+        size_t step = (words + chunks - 1) / chunks;
+        {
+            std::vector<std::jthread> pool;
+            for (size_t first = 0; first < words; first += step) {
+                pool.emplace_back([&func, &total, first, last = std::min(words, first + step)] { total += func(first, last); });
+            }
+        }
+        return total;
+    }
+
+    //  push:      out
+    template <bool out>
+    size_t Push(TBitset const& frontier, TBitset& visited, TBitset& next, std::vector<uint32_t>* depth, uint32_t level) const {
+        return Parallel(frontier.words_count(), [&](size_t first, size_t last) {
+            size_t found = 0;
+            for (size_t i = first; i < last; ++i) {
+                for (uint64_t w = frontier.word(i); w; w &= w - 1) {
+                    idx_type v = static_cast<idx_type>(i * TBitset::word_bits + std::countr_zero(w));
+                    ForEachNeighbor<out>(v, [&](idx_type u) {
+                        if (visited.set_atomic(u)) {
+                            next.set_atomic(u);
+                            if (depth) (*depth)[u] = level;
+                            ++found;
+                        }
+                        return false;
+                    });
+                }
+            }
+            return found;
+        });
+    }
+
+    //  pull:  ,         out
+    //    ,      
+    template <bool out>
+    size_t Pull(TBitset const& frontier, TBitset& visited, TBitset& next, std::vector<uint32_t>* depth, uint32_t level) const {
+        return Parallel(visited.words_count(), [&](size_t first, size_t last) {
+            size_t found = 0;
+            for (size_t i = first; i < last; ++i) {
+                uint64_t added = 0;
+                for (uint64_t w = ~visited.word(i) & visited.word_mask(i); w; w &= w - 1) {
+                    idx_type u = static_cast<idx_type>(i * TBitset::word_bits + std::countr_zero(w));
+                    ForEachNeighbor<out>(u, [&](idx_type v) {
+                        if (!frontier.test(v)) return false;
+                        added |= w & (~w + 1);
+                        if (depth) (*depth)[u] = level;
+                        return true;
+                    });
+                }
+                visited.word(i) |= added;
+                next.word(i) = added;
+                found += std::popcount(added);
+            }
+            return found;
+        });
+    }
+
+public:
+    // threads = 0 -    
+    explicit TTraversal(TGraph const& graph, size_t threads = 0)
+        : graph(graph)
+        , threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+    {}
+
+    //  ,   sources (  )
+    // depth ( )      (NO_DEPTH -  )
+    TBitset Reach(std::vector<idx_type> const& sources, TTraversalDirection direction = tdForward, std::vector<uint32_t>* depth = nullptr) const {
+        size_t const count = graph.vertex.size();
+        bool const forward = direction == tdForward;
+        bool const can_push = forward ? has_out : has_in;
+        bool const can_pull = forward ? has_in : has_out;
+
+        TBitset visited(count), frontier(count), next(count);
+        if (depth) depth->assign(count, NO_DEPTH);
+
+        size_t frontier_count = 0;
+        for (idx_type v : sources) {
+            if (v >= count) throw std::invalid_argument("Error in Reach(sources): source >= vertex.size()");
+            if (!visited.set_atomic(v)) continue;
+            frontier.set(v);
+            if (depth) (*depth)[v] = 0;
+            ++frontier_count;
+        }
+
+        size_t unvisited = count - frontier_count;
+        bool pull = !can_push;
+        for (uint32_t level = 1; frontier_count > 0 and unvisited > 0; ++level) {
+            if (can_push and can_pull) {
+                if (!pull and frontier_count > unvisited / alpha) pull = true;
+                else if (pull and frontier_count < count / beta) pull = false;
+            }
+
+            next.clear();
+            if (forward) frontier_count = pull ? Pull<false>(frontier, visited, next, depth, level) : Push<true >(frontier, visited, next, depth, level);
+            else         frontier_count = pull ? Pull<true >(frontier, visited, next, depth, level) : Push<false>(frontier, visited, next, depth, level);
+
+            unvisited -= frontier_count;
+            std::swap(frontier, next);
+        }
+        return visited;
+    }
+};
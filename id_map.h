@@ -0,0 +1,74 @@
+/* ******************************************************************************************************** */
+/*                            ( 64- )                            */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+//         0, 1, 2, ...
+//   -  ;  Build()       .
+class TIdMap {
+private:
+    using TPair = std::pair<uint64_t, size_t>; // ( ,  )
+
+    static constexpr size_t const parallel_sort_min = 1 << 16; //       
+
+    std::vector<uint64_t> ids; //    
+    std::vector<TPair> sorted; //     
+
+public:
+    static constexpr size_t const npos = static_cast<size_t>(-1);
+
+    size_t size() const { return ids.size(); }
+
+    void reserve(size_t n) { ids.reserve(n); }
+
+    //  ,    
+    size_t Add(uint64_t id) {
+        ids.push_back(id);
+        return ids.size() - 1;
+    }
+
+    uint64_t Id(size_t idx) const { return ids[idx]; }
+
+    //   (  ,  )
+    //         (npos -  )
+    size_t Build(size_t threads = 0) {
+        sorted.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) sorted[i] = { ids[i], i };
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunks = std::clamp<size_t>(sorted.size() / parallel_sort_min, 1, threads);
+        size_t chunk_size = (sorted.size() + chunks - 1) / chunks;
+        std::vector<size_t> bounds;
+        for (size_t b = 0; b < sorted.size(); b += chunk_size) bounds.push_back(b);
+        bounds.push_back(sorted.size());
+        {
+            std::vector<std::jthread> workers;
+            for (size_t c = 0; c + 1 < bounds.size(); ++c) {
+                workers.emplace_back([this, first = bounds[c], last = bounds[c + 1]] {
+                    std::sort(sorted.begin() + first, sorted.begin() + last);
+                });
+            }
+        }
+        for (size_t c = 1; c + 1 < bounds.size(); ++c) {
+            std::inplace_merge(sorted.begin(), sorted.begin() + bounds[c], sorted.begin() + bounds[c + 1]);
+        }
+
+        size_t dup = npos;
+        for (size_t i = 1; i < sorted.size(); ++i) {
+            if (sorted[i].first == sorted[i - 1].first) dup = std::min(dup, sorted[i].second);
+        }
+        return dup;
+    }
+
+    //     (npos -  )
+    size_t Find(uint64_t id) const {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), id, [](TPair const& p, uint64_t id) { return p.first < id; });
+        return (it == sorted.end() or it->first != id) ? npos : it->second;
+    }
+};
@@ -0,0 +1,353 @@
+/* ******************************************************************************************************** */
+/*                                ƨ                                      */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+//     ( )
+enum TAccessAdvice { aaNormal = 0, aaSequential, aaRandom, aaWillNeed, aaDontNeed };
+
+//      (   )
+template <typename TArray, typename... types>
+inline void StorageAdvise(TArray& arr, types... args) {
+    if constexpr (requires { arr.Advise(args...); }) arr.Advise(args...);
+}
+
+//    (   ,    )
+inline unsigned long long CurrentProcessId() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long long>(getpid());
+#endif // _WIN32
+}
+
+//  ,    (  )
+class TMappedFile {
+private:
+    void* addr{ nullptr };
+    size_t bytes{ 0 };
+#ifdef _WIN32
+    HANDLE file{ INVALID_HANDLE_VALUE };
+    HANDLE mapping{ nullptr };
+#endif // _WIN32
+
+    static std::filesystem::path Directory() {
+        return directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory);
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (addr) UnmapViewOfFile(addr);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (addr) munmap(addr, bytes);
+#endif // _WIN32
+        addr = nullptr;
+        bytes = 0;
+    }
+
+public:
+    static inline std::string directory{}; //    ( -  )
+
+    TMappedFile() = default;
+
+    explicit TMappedFile(size_t size) : bytes(size) {
+        if (bytes == 0) return;
+#ifdef _WIN32
+        wchar_t name[MAX_PATH];
+        if (GetTempFileNameW(Directory().c_str(), L"gar", 0, name) == 0)
+            throw std::runtime_error("     : \"" + Directory().string() + "\"");
+        file = CreateFileW(name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            DeleteFileW(name);
+            throw std::runtime_error("    ");
+        }
+        ULARGE_INTEGER len;
+        len.QuadPart = bytes;
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, len.HighPart, len.LowPart, nullptr);
+        if (mapping) addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+        if (!addr) {
+            Close();
+            throw std::runtime_error("      ");
+        }
+#else
+        std::string name = (Directory() / "gar_XXXXXX").string();
+        int fd = mkstemp(name.data());
+        if (fd < 0) throw std::runtime_error("    : \"" + name + "\"");
+        unlink(name.c_str()); //  ,  
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            close(fd);
+            throw std::runtime_error("     : \"" + name + "\"");
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            bytes = 0;
+            throw std::runtime_error("      ");
+        }
+        addr = p;
+#endif // _WIN32
+    }
+
+    //      
+    explicit TMappedFile(std::filesystem::path const& path) {
+#ifdef _WIN32
+        file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("   : \"" + path.string() + "\"");
+        LARGE_INTEGER len;
+        if (!GetFileSizeEx(file, &len)) {
+            Close();
+            throw std::runtime_error("    : \"" + path.string() + "\"");
+        }
+        if (len.QuadPart == 0) return;
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!addr) {
+            Close();
+            throw std::runtime_error("     : \"" + path.string() + "\"");
+        }
+        bytes = static_cast<size_t>(len.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("   : \"" + path.string() + "\"");
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("    : \"" + path.string() + "\"");
+        }
+        if (st.st_size > 0) {
+            void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("     : \"" + path.string() + "\"");
+            }
+            addr = p;
+            bytes = static_cast<size_t>(st.st_size);
+        }
+        close(fd);
+#endif // _WIN32
+    }
+
+    TMappedFile(TMappedFile const&) = delete;
+    TMappedFile& operator=(TMappedFile const&) = delete;
+
+    TMappedFile(TMappedFile&& other) noexcept { swap(other); }
+
+    TMappedFile& operator=(TMappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~TMappedFile() { Close(); }
+
+    void swap(TMappedFile& other) noexcept {
+        std::swap(addr, other.addr);
+        std::swap(bytes, other.bytes);
+#ifdef _WIN32
+        std::swap(file, other.file);
+        std::swap(mapping, other.mapping);
+#endif // _WIN32
+    }
+
+    void* data() const { return addr; }
+    size_t size() const { return bytes; }
+
+    //        [offset, offset + len)
+    void Advise(TAccessAdvice advice, size_t offset, size_t len) const {
+        if (!addr or len == 0 or offset >= bytes) return;
+        len = std::min(len, bytes - offset);
+#ifdef _WIN32
+        //   Windows    
+        if (advice == aaWillNeed) {
+            WIN32_MEMORY_RANGE_ENTRY range{ static_cast<char*>(addr) + offset, len };
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+#else
+        static size_t const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t begin = offset / page * page; // madvise    
+        int a = MADV_NORMAL;
+        switch (advice) {
+        case aaSequential: a = MADV_SEQUENTIAL; break;
+        case aaRandom    : a = MADV_RANDOM    ; break;
+        case aaWillNeed  : a = MADV_WILLNEED  ; break;
+        case aaDontNeed  : a = MADV_DONTNEED  ; break;
+        default: break;
+        }
+        madvise(static_cast<char*>(addr) + begin, offset + len - begin, a);
+#endif // _WIN32
+    }
+};
+
+//        (  std::vector)
+template <typename T>
+class TMappedVector {
+private:
+    static constexpr size_t const min_capacity = 4096 / sizeof(T) > 0 ? 4096 / sizeof(T) : 1;
+
+    TMappedFile file{};
+    size_t count{ 0 };
+    size_t capacity_{ 0 };
+
+    T* ptr() const { return static_cast<T*>(file.data()); }
+
+    //       
+    void Reallocate(size_t new_capacity) {
+        //  std::vector:      
+        if (new_capacity > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::length_error("TMappedVector: size is too large");
+        TMappedFile new_file(new_capacity * sizeof(T));
+        T* dst = static_cast<T*>(new_file.data());
+        T* src = ptr();
+        for (size_t i = 0; i < count; ++i) {
+            new (dst + i) T(std::move(src[i]));
+            src[i].~T();
+        }
+        file = std::move(new_file);
+        capacity_ = new_capacity;
+    }
+
+    void Grow(size_t need) {
+        if (need > capacity_) Reallocate(std::max({ need, capacity_ * 2, min_capacity }));
+    }
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = T const*;
+
+    TMappedVector() = default;
+
+    explicit TMappedVector(size_t n) { resize(n); }
+
+    TMappedVector(size_t n, T const& val) { resize(n, val); }
+
+    TMappedVector(TMappedVector const&) = delete;
+    TMappedVector& operator=(TMappedVector const&) = delete;
+
+    TMappedVector(TMappedVector&& other) noexcept { swap(other); }
+
+    TMappedVector& operator=(TMappedVector&& other) noexcept {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~TMappedVector() { clear(); }
+
+    void swap(TMappedVector& other) noexcept {
+        file.swap(other.file);
+        std::swap(count, other.count);
+        std::swap(capacity_, other.capacity_);
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return count == 0; }
+
+    T      * data()       { return ptr(); }
+    T const* data() const { return ptr(); }
+
+    T      & operator[] (size_t idx)       { return ptr()[idx]; }
+    T const& operator[] (size_t idx) const { return ptr()[idx]; }
+
+    T      & back()       { return ptr()[count - 1]; }
+    T const& back() const { return ptr()[count - 1]; }
+
+    iterator       begin()       { return ptr(); }
+    iterator       end()         { return ptr() + count; }
+    const_iterator begin() const { return ptr(); }
+    const_iterator end()   const { return ptr() + count; }
+
+    void reserve(size_t n) {
+        if (n > capacity_) Reallocate(n);
+    }
+
+    void resize(size_t n) {
+        Grow(n);
+        for (size_t i = count; i < n; ++i) new (ptr() + i) T();
+        for (size_t i = n; i < count; ++i) ptr()[i].~T();
+        count = n;
+    }
+
+    void resize(size_t n, T const& val) {
+        T copy(val); // val      ,   Grow
+        Grow(n);
+        for (size_t i = count; i < n; ++i) new (ptr() + i) T(copy);
+        for (size_t i = n; i < count; ++i) ptr()[i].~T();
+        count = n;
+    }
+
+    template <typename... types>
+    T& emplace_back(types&&... args) {
+        if (count == capacity_) {
+            //        ,     
+            T val(std::forward<types>(args)...);
+            Grow(count + 1);
+            T* p = new (ptr() + count) T(std::move(val));
+            ++count;
+            return *p;
+        }
+        T* p = new (ptr() + count) T(std::forward<types>(args)...);
+        ++count;
+        return *p;
+    }
+
+    void push_back(T const& val) { emplace_back(val); }
+    void push_back(T&& val) { emplace_back(std::move(val)); }
+
+    void clear() {
+        for (size_t i = 0; i < count; ++i) ptr()[i].~T();
+        count = 0;
+    }
+
+    //            
+    void Advise(TAccessAdvice advice) const { file.Advise(advice, 0, count * sizeof(T)); }
+    void Advise(TAccessAdvice advice, size_t first, size_t n) const { file.Advise(advice, first * sizeof(T), n * sizeof(T)); }
+};
+
+//    
+
+//   
+struct TVectorStorage {
+    template <typename T>
+    using array = std::vector<T>;
+};
+
+//   ,    (    )
+struct TMappedStorage {
+    template <typename T>
+    using array = TMappedVector<T>;
+};
@@ -0,0 +1,100 @@
+/* ******************************************************************************************************** */
+/*                                                                               */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+#include "ritm_test_suppor.h"
+
+//    
+struct TMemoStats {
+    uint64_t hits{ 0 };
+    uint64_t misses{ 0 };
+};
+
+//       
+//        (    ),
+//     ,     -    .
+//    ,       .
+template <typename value_type>
+class TMemoCache {
+    static_assert(std::is_trivially_copyable_v<value_type>, "TMemoCache: value_type must be trivially copyable");
+
+private:
+    struct TEntry {
+        bool used{ false };
+        uint64_t hash{ 0 };
+        std::vector<value_type> args;
+        value_type result{};
+    };
+
+    struct TSegment {
+        std::mutex mutex;
+        std::vector<TEntry> entries;
+    };
+
+    std::unique_ptr<TSegment[]> segments;
+    size_t segments_count;
+    size_t segment_size;
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> misses{ 0 };
+
+    static uint64_t Hash(std::vector<value_type> const& args) {
+        return THash{}.add(args.data(), args.size() * sizeof(value_type)).add(static_cast<uint64_t>(args.size())).value;
+    }
+
+public:
+    // capacity -   
+    explicit TMemoCache(size_t capacity = 1 << 16, size_t segments_count = 16)
+        : segments(new TSegment[std::max<size_t>(1, segments_count)])
+        , segments_count(std::max<size_t>(1, segments_count))
+        , segment_size(std::max<size_t>(1, capacity / std::max<size_t>(1, segments_count)))
+    {
+        for (size_t i = 0; i < this->segments_count; ++i) segments[i].entries.resize(segment_size);
+    }
+
+    //     func(args)    
+    template <typename TFunc>
+    value_type Get(std::vector<value_type> const& args, TFunc const& func) {
+        uint64_t hash = Hash(args);
+        TSegment& segment = segments[hash % segments_count];
+        size_t slot = (hash / segments_count) % segment_size;
+        {
+            std::lock_guard lock(segment.mutex);
+            TEntry const& entry = segment.entries[slot];
+            if (entry.used and entry.hash == hash and entry.args == args) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return entry.result;
+            }
+        }
+
+        misses.fetch_add(1, std::memory_order_relaxed);
+        value_type result = func(args);
+
+        std::lock_guard lock(segment.mutex);
+        TEntry& entry = segment.entries[slot];
+        entry.used = true;
+        entry.hash = hash;
+        entry.args.assign(args.begin(), args.end()); //    
+        entry.result = result;
+        return result;
+    }
+
+    TMemoStats Stats() const { return { hits.load(), misses.load() }; }
+
+    void Clear() {
+        for (size_t i = 0; i < segments_count; ++i) {
+            std::lock_guard lock(segments[i].mutex);
+            for (TEntry& entry : segments[i].entries) entry.used = false;
+        }
+        hits = 0;
+        misses = 0;
+    }
+};
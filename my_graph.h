@@ -10,6 +10,12 @@
 #include <vector>
 #include <stack>
 #include <cassert>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include <stdexcept>
+
+#include "mapped_storage.h"
 
 // TAttribute
 
@@ -25,6 +31,11 @@ public:
         T attribute;
         TAValue() = default;
         TAValue(T attribute) : attribute(attribute) {}
+
+        template <typename A0, typename A1, typename... types>
+        TAValue(A0&& a0, A1&& a1, types&&... args)
+            : attribute(std::forward<A0>(a0), std::forward<A1>(a1), std::forward<types>(args)...)
+        {}
     };
 
     template <typename T>
@@ -45,7 +56,7 @@ public:
 
     static constexpr atr_type signal = std::is_void_v<value_type>
         ? atEmpty
-        : (std::is_fundamental_v<value_type> or std::is_pointer_v<value_type>
+        : (std::is_fundamental_v<value_type> or std::is_pointer_v<value_type> or std::is_trivially_copyable_v<value_type>
             ? atValue
             : (std::is_function_v<value_type>
                 ? atFunc
@@ -86,7 +97,80 @@ using TVertAttrValueType = TVertAnnotatedSpec<value_type, IsVertAnnotated<annota
 template <typename value_type, TAnnotatedSpec annotated_spec>
 using TEdgeAttrValueType = TEdgeAnnotatedSpec<value_type, IsEdgeAnnotated<annotated_spec>>::arrt_value_type;
 
-template <std::unsigned_integral idx_type_ = size_t, typename attr_value_type_ = void, TAnnotatedSpec annotated_spec = asNone>
+//   :  ,  ,    
+// (  from/to  )
+enum TTopologySpec { tsNone = 0, tsOut = 1, tsIn = 2, tsBoth = tsOut | tsIn };
+
+template <TTopologySpec topology>
+constexpr bool HasOutputs = static_cast<bool>(topology & tsOut);
+
+template <TTopologySpec topology>
+constexpr bool HasInputs = static_cast<bool>(topology & tsIn);
+
+//      ( viewer' idx_type - const)
+template <typename idx_type, TTopologySpec topology> struct TVertLinks;
+
+template <typename idx_type> struct TVertLinks<idx_type, tsBoth> {
+    idx_type first_input { std::numeric_limits<idx_type>::max() };
+    idx_type first_output{ std::numeric_limits<idx_type>::max() };
+};
+
+template <typename idx_type> struct TVertLinks<idx_type, tsOut> {
+    idx_type first_output{ std::numeric_limits<idx_type>::max() };
+};
+
+template <typename idx_type> struct TVertLinks<idx_type, tsIn> {
+    idx_type first_input { std::numeric_limits<idx_type>::max() };
+};
+
+template <typename idx_type> struct TVertLinks<idx_type, tsNone> {};
+
+//  :        
+template <typename idx_type, TTopologySpec topology> struct TEdgeLinks;
+
+template <typename idx_type> struct TEdgeLinks<idx_type, tsBoth> {
+    idx_type from;
+    idx_type to;
+    idx_type next_from;
+    idx_type next_to;
+
+    TEdgeLinks(idx_type from, idx_type to, idx_type next_from, idx_type next_to)
+        : from(from), to(to), next_from(next_from), next_to(next_to) {};
+};
+
+template <typename idx_type> struct TEdgeLinks<idx_type, tsOut> {
+    idx_type from;
+    idx_type to;
+    idx_type next_from;
+
+    TEdgeLinks(idx_type from, idx_type to, idx_type next_from, idx_type)
+        : from(from), to(to), next_from(next_from) {};
+};
+
+template <typename idx_type> struct TEdgeLinks<idx_type, tsIn> {
+    idx_type from;
+    idx_type to;
+    idx_type next_to;
+
+    TEdgeLinks(idx_type from, idx_type to, idx_type, idx_type next_to)
+        : from(from), to(to), next_to(next_to) {};
+};
+
+template <typename idx_type> struct TEdgeLinks<idx_type, tsNone> {
+    idx_type from;
+    idx_type to;
+
+    TEdgeLinks(idx_type from, idx_type to, idx_type, idx_type)
+        : from(from), to(to) {};
+};
+
+template <
+    std::unsigned_integral idx_type_ = size_t,
+    typename attr_value_type_ = void,
+    TAnnotatedSpec annotated_spec = asNone,
+    TTopologySpec topology = tsBoth, //    
+    typename storage_policy_ = TVectorStorage //      
+>
 class TGraph_ {
 #ifdef TEST_MODE
     friend int test_main();
@@ -97,20 +181,18 @@ public:
     using attr_value_type = attr_value_type_;
     using v_attr_value_t = TVertAttrValueType<attr_value_type_, annotated_spec>;
     using e_attr_value_t = TEdgeAttrValueType<attr_value_type_, annotated_spec>;
+    using storage_policy = storage_policy_;
+    static constexpr TTopologySpec const topology_spec = topology;
+
+    template <typename T>
+    using TArray = typename storage_policy::template array<T>;
 
     using TVertAttrBase = TAttribute<v_attr_value_t>;
     using TEdgeAttrBase = TAttribute<e_attr_value_t>;
 
     // TVertex
-    struct TVertViewerBase {
-        idx_type const first_input;
-        idx_type const first_output;
-    };
-
-    struct TVertBase {
-        idx_type first_input { BAD_IDX };
-        idx_type first_output{ BAD_IDX };
-    };
+    using TVertViewerBase = TVertLinks<idx_type const, topology>;
+    using TVertBase = TVertLinks<idx_type, topology>;
 
     struct TVert : public TVertBase, public TVertAttrBase {
         template <typename... types>
@@ -131,32 +213,14 @@ public:
     public:
         TVertArrViewer() = delete;
         TVertArrViewer(TGraph_& graph) : graph(graph) {};
-        idx_type size() { return static_cast<idx_type>(graph.vert_arr.size()); }
+        idx_type size() const { return static_cast<idx_type>(graph.vert_arr.size()); }
         decltype(auto) operator[] (idx_type idx)       { return graph.vert_arr[idx].view(); }
         decltype(auto) operator[] (idx_type idx) const { return graph.vert_arr[idx].view(); }
     };
 
     // TEdge
-    struct TEdgeViewerBase {
-        idx_type const from;
-        idx_type const to;
-        idx_type const next_from;
-        idx_type const next_to;
-    };
-
-    struct TEdgeBase {
-        idx_type from;
-        idx_type to;
-        idx_type next_from;
-        idx_type next_to;
-
-        TEdgeBase(idx_type from, idx_type to, idx_type next_from, idx_type next_to)
-            : from(from)
-            , to(to)
-            , next_from(next_from)
-            , next_to(next_to)
-        {};
-    };
+    using TEdgeViewerBase = TEdgeLinks<idx_type const, topology>;
+    using TEdgeBase = TEdgeLinks<idx_type, topology>;
 
     struct TEdge final : public TEdgeBase, public TEdgeAttrBase {
         TEdge() = delete;
@@ -184,7 +248,7 @@ public:
     public:
         TEdgeArrViewer() = delete;
         TEdgeArrViewer(TGraph_& graph) : graph(graph) {};
-        idx_type size() { return static_cast<idx_type>(graph._edges.size()); }
+        idx_type size() const { return static_cast<idx_type>(graph.edge_arr.size()); }
         decltype(auto) operator[] (idx_type idx)       { return graph.edge_arr[idx].view(); }
         decltype(auto) operator[] (idx_type idx) const { return graph.edge_arr[idx].view(); }
     };
@@ -200,8 +264,8 @@ public:
         bool end_e() { return e == BAD_IDX; }
 
         void go_e() {
-            v = g.edge_arr[e].to;
-            g.vert_arr[v].first_output;
+            v = g->edge_arr[e].to;
+            e = g->vert_arr[v].first_output;
         }
 
         idx_type look_e() { return g->edge_arr[e].to; }
@@ -212,15 +276,21 @@ public:
         const TVertBase& operator->() { return g->vert_arr[v]; }
     };
 
-    TIterator GetIterator(idx_type vertex_idx) {
+    TIterator GetIterator(idx_type vertex_idx) requires HasOutputs<topology> {
         return TIterator(*this, vertex_idx);
     }
 
 
 private:
 
-    std::vector<TVert> vert_arr;
-    std::vector<TEdge> edge_arr;
+    TArray<TVert> vert_arr;
+    TArray<TEdge> edge_arr;
+
+    void CheckEdge(idx_type from, idx_type to) const {
+        if (from >= vert_arr.size() or to >= vert_arr.size()) {
+            throw std::invalid_argument("Error in AddEdge(from, to): from|to >= vertex.size()");
+        }
+    }
 
 public:
 
@@ -229,6 +299,12 @@ public:
 
     TGraph_() : vert_arr(), edge_arr(), edge(*this), vertex(*this) {}
 
+    //         
+    void Advise(TAccessAdvice advice) {
+        StorageAdvise(vert_arr, advice);
+        StorageAdvise(edge_arr, advice);
+    }
+
     void AddVertexes(idx_type count) {
         vert_arr.resize(vert_arr.size() + count);
     }
@@ -240,27 +316,126 @@ public:
 
     template <typename... types>
     TEdge& AddEdge(idx_type from, idx_type to, types&&... args) {
-        if (from >= vert_arr.size() or to >= vert_arr.size()) {
-            throw std::invalid_argument("Error in AddEdge(from, to): from|to >= vertex.size()");
-        }
-        idx_type& vffo = vert_arr[from].first_output;
-        idx_type& vtfi = vert_arr[to].first_input;
-        idx_type next_from = vffo;
-        idx_type next_to = vtfi;
+        CheckEdge(from, to);
         idx_type self = static_cast<idx_type>(edge_arr.size());
-        vffo = self;
-        vtfi = self;
+        idx_type next_from = BAD_IDX;
+        idx_type next_to = BAD_IDX;
+        if constexpr (HasOutputs<topology>) next_from = std::exchange(vert_arr[from].first_output, self);
+        if constexpr (HasInputs <topology>) next_to   = std::exchange(vert_arr[to  ].first_input , self);
         return edge_arr.emplace_back(from, to, next_from, next_to, std::forward<types>(args)...);
     }
 
-    //    
-    void TopSort(bool ignor_cycle = false) {
+    //    (  ,  -   )
+    //     ,     (AddEdge)    (SetEdge),
+    //       CAS',       .
+    // Publish()     ;        .
+    //        AddEdge,    SetEdge ( -  ).
+    class TConcurrentEdges {
+    private:
+        enum TMode : uint8_t { mNone = 0, mSet, mAdd }; //    (  )
+
+        TGraph_& graph;
+        idx_type first; //   
+        idx_type count; //   
+        std::atomic<idx_type> reserved{ 0 }; //    AddEdge
+        std::atomic<TMode> mode{ mNone };
+
+        void SetMode(TMode m) {
+            TMode old = mode.load(std::memory_order_relaxed);
+            if (old == mNone and mode.compare_exchange_strong(old, m, std::memory_order_relaxed)) return;
+            if (old != m) throw std::logic_error("Error in TConcurrentEdges: AddEdge and SetEdge cannot be mixed");
+        }
+
+        //   ,      from (  - )
+        template <typename... types>
+        void Fill(idx_type slot, idx_type from, idx_type to, types&&... args) {
+            idx_type self = first + slot;
+            TEdge& edge = graph.edge_arr[self];
+            idx_type blank = BAD_IDX;
+            if (!std::atomic_ref<idx_type>(edge.from).compare_exchange_strong(blank, from, std::memory_order_relaxed)) {
+                throw std::logic_error("Error in SetEdge(slot, from, to): slot is already filled");
+            }
+            edge = TEdge(from, to, BAD_IDX, BAD_IDX, std::forward<types>(args)...);
+            if constexpr (HasOutputs<topology>) Link(graph.vert_arr[from].first_output, edge.next_from, self);
+            if constexpr (HasInputs <topology>) Link(graph.vert_arr[to  ].first_input , edge.next_to  , self);
+        }
+
+        static TEdge Blank() { return TEdge(BAD_IDX, BAD_IDX, BAD_IDX, BAD_IDX); }
+
+        //     : head -   , next -    
+        static void Link(idx_type& head, idx_type& next, idx_type self) {
+            std::atomic_ref<idx_type> ahead(head);
+            idx_type old = ahead.load(std::memory_order_relaxed);
+            do {
+                next = old;
+            } while (!ahead.compare_exchange_weak(old, self, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    public:
+        TConcurrentEdges(TGraph_& graph, idx_type count)
+            : graph(graph)
+            , first(static_cast<idx_type>(graph.edge_arr.size()))
+            , count(count)
+        {
+            graph.edge_arr.resize(first + count, Blank());
+        }
+
+        TConcurrentEdges(TConcurrentEdges const&) = delete;
+        TConcurrentEdges& operator=(TConcurrentEdges const&) = delete;
+
+        //     (0 <= slot < count,     )
+        template <typename... types>
+        void SetEdge(idx_type slot, idx_type from, idx_type to, types&&... args) {
+            if (slot >= count) throw std::out_of_range("Error in SetEdge(slot, from, to): slot >= reserved edges count");
+            graph.CheckEdge(from, to);
+            SetMode(mSet);
+            Fill(slot, from, to, std::forward<types>(args)...);
+        }
+
+        //     ,   
+        template <typename... types>
+        idx_type AddEdge(idx_type from, idx_type to, types&&... args) {
+            graph.CheckEdge(from, to);
+            SetMode(mAdd);
+            idx_type slot = reserved.fetch_add(1, std::memory_order_relaxed);
+            if (slot >= count) throw std::length_error("Error in AddEdge(from, to): reserved edges are exhausted");
+            Fill(slot, from, to, std::forward<types>(args)...);
+            return first + slot;
+        }
+
+        //  :   AddEdge ( ,    ) ,
+        //   SetEdge -  (     )
+        TGraph_& Publish() {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mode.load(std::memory_order_relaxed) != mSet) {
+                idx_type used = std::min(reserved.load(std::memory_order_relaxed), count);
+                graph.edge_arr.resize(first + used, Blank());
+            }
+            for (idx_type e = first; e < graph.edge_arr.size(); ++e) {
+                if (graph.edge_arr[e].from == BAD_IDX) throw std::logic_error("Error in Publish(): edge slot " + std::to_string(e - first) + " is not filled");
+            }
+            return graph;
+        }
+    };
+
+    TConcurrentEdges ConcurrentEdges(idx_type count) {
+        return TConcurrentEdges(*this, count);
+    }
+
+    //      (viewer'     )
+    void Swap(TGraph_& other) {
+        std::swap(vert_arr, other.vert_arr);
+        std::swap(edge_arr, other.edge_arr);
+    }
+
+    //     (   )
+    void TopSort(bool ignor_cycle = false) requires HasOutputs<topology> {
         enum state_t { sWhite = 0, sGrey = 1, sBlack = 2 };
 
         std::stack<TIterator> stack; // 
-        std::vector<state_t> state(vert_arr.size(), sWhite); //  
-        std::vector<idx_type> v_vec; //   
-        std::vector<idx_type> e_vec(vert_arr.size()); //   
+        TArray<state_t> state(vert_arr.size(), sWhite); //  
+        TArray<idx_type> v_vec; //   
+        TArray<idx_type> e_vec(vert_arr.size()); //   
 
         v_vec.reserve(vert_arr.size());
 
@@ -301,7 +476,7 @@ public:
 
         assert(v_vec.size() == vert_arr.size());
 
-        std::vector<TVert> new_vert_arr(vert_arr.size());
+        TArray<TVert> new_vert_arr(vert_arr.size());
         for (int v = 0; v < vert_arr.size(); ++v) {
             std::swap(new_vert_arr[v], vert_arr[v_vec[v]]);
         }
@@ -314,8 +489,8 @@ public:
     }
 };
 
-template <std::integral idx_type = size_t>
-using TGraph = TGraph_<std::make_unsigned_t<idx_type>>;
+template <std::integral idx_type = size_t, typename storage_policy = TVectorStorage, TTopologySpec topology = tsBoth>
+using TGraph = TGraph_<std::make_unsigned_t<idx_type>, void, asNone, topology, storage_policy>;
 
-template <typename attr_value_type, TAnnotatedSpec annotated_spec = asAll, std::integral idx_type = size_t>
-using TAnnotatedGraph = TGraph_<std::make_unsigned_t<idx_type>, attr_value_type, annotated_spec>;
+template <typename attr_value_type, TAnnotatedSpec annotated_spec = asAll, std::integral idx_type = size_t, typename storage_policy = TVectorStorage, TTopologySpec topology = tsBoth>
+using TAnnotatedGraph = TGraph_<std::make_unsigned_t<idx_type>, attr_value_type, annotated_spec, topology, storage_policy>;
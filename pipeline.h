@@ -0,0 +1,162 @@
+/* ******************************************************************************************************** */
+/*                                                                            */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <limits>
+#include <istream>
+
+#include "ritm_test_suppor.h"
+
+//     
+// Close()    -   (    ),
+//    -    (Push()  false)
+template <typename T>
+class TBoundedQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<T> queue;
+    size_t capacity;
+    bool closed{ false };
+
+public:
+    explicit TBoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    bool Push(T&& val) {
+        std::unique_lock lock(mutex);
+        not_full.wait(lock, [this] { return closed or queue.size() < capacity; });
+        if (closed) return false;
+        queue.push_back(std::move(val));
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool Pop(T& val) {
+        std::unique_lock lock(mutex);
+        not_empty.wait(lock, [this] { return closed or !queue.empty(); });
+        if (queue.empty()) return false;
+        val = std::move(queue.front());
+        queue.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+};
+
+//    
+struct TLineBatch {
+    size_t first_line{ 0 }; //     ( 1)
+    std::vector<std::string> lines;
+};
+
+//    :          
+class TLineReader {
+private:
+    TBoundedQueue<std::string> blocks;
+    TBoundedQueue<TLineBatch> batches;
+    std::jthread reader;
+    std::jthread splitter;
+
+    void Read(std::istream& IN, size_t block_size) {
+        while (IN) {
+            std::string block(block_size, '\0');
+            IN.read(block.data(), block_size);
+            block.resize(static_cast<size_t>(IN.gcount()));
+            if (block.empty() or !blocks.Push(std::move(block))) break;
+        }
+        blocks.Close();
+    }
+
+    void Split(size_t batch_lines) {
+        TLineBatch batch{ 1, {} };
+        batch.lines.reserve(batch_lines);
+        std::string tail; //  ,     
+        std::string block;
+
+        auto flush = [&]() {
+            size_t next_line = batch.first_line + batch.lines.size();
+            bool ok = batches.Push(std::move(batch));
+            batch = TLineBatch{ next_line, {} };
+            batch.lines.reserve(batch_lines);
+            return ok;
+        };
+
+        while (blocks.Pop(block)) {
+            size_t pos = 0;
+            for (size_t eol; (eol = block.find('\n', pos)) != std::string::npos; pos = eol + 1) {
+                tail.append(block, pos, eol - pos);
+                batch.lines.push_back(std::move(tail));
+                tail.clear();
+                if (batch.lines.size() == batch_lines and !flush()) {
+                    blocks.Close();
+                    return;
+                }
+            }
+            tail.append(block, pos);
+        }
+        if (!tail.empty()) batch.lines.push_back(std::move(tail));
+        if (!batch.lines.empty()) flush();
+        batches.Close();
+    }
+
+public:
+    TLineReader(std::istream& IN, size_t batch_lines = 16384, size_t block_size = 1 << 20, size_t depth = 8)
+        : blocks(depth)
+        , batches(depth)
+        , reader([this, &IN, block_size] { Read(IN, block_size); })
+        , splitter([this, batch_lines] { Split(batch_lines); })
+    {}
+
+    ~TLineReader() { Stop(); }
+
+    //    (false -  )
+    bool Next(TLineBatch& batch) { return batches.Pop(batch); }
+
+    //   
+    void Stop() {
+        batches.Close();
+        blocks.Close();
+    }
+};
+
+//       
+class TFirstError {
+private:
+    std::mutex mutex;
+    std::atomic<bool> any{ false };
+    size_t line{ std::numeric_limits<size_t>::max() };
+    int exit_code{ 0 };
+    std::string message;
+
+public:
+    void Set(EAbort const& exc) {
+        std::lock_guard lock(mutex);
+        if (!any or exc.line() < line) {
+            line = exc.line();
+            exit_code = exc.exit_code();
+            message = exc.what();
+        }
+        any = true;
+    }
+
+    bool Any() const { return any; }
+
+    void ThrowIfAny() {
+        if (any) throw_abort(message, exit_code, line);
+    }
+};
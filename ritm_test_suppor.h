@@ -7,6 +7,11 @@
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <string>
+#include <vector>
 
 // 
 
@@ -15,20 +20,53 @@ public:
     using _Mybase = runtime_error;
 private:
     int _exit_code;
+    size_t _line; //    ,     (0 -  )
 
-    explicit EAbort(std::string const& _Message, int exit_code) : _Mybase(_Message.c_str()), _exit_code(exit_code) {}
-    explicit EAbort(char        const* _Message, int exit_code) : _Mybase(_Message), _exit_code(exit_code) {}
+    explicit EAbort(std::string const& _Message, int exit_code, size_t line) : _Mybase(_Message.c_str()), _exit_code(exit_code), _line(line) {}
+    explicit EAbort(char        const* _Message, int exit_code, size_t line) : _Mybase(_Message), _exit_code(exit_code), _line(line) {}
 
 public:
     [[nodiscard]] virtual int exit_code() const { return _exit_code; }
+    [[nodiscard]] size_t line() const { return _line; }
 
-    [[noreturn]] static inline void throw_abort(const std::string& message, int exit_code) { throw EAbort(message, exit_code); }
-    [[noreturn]] static inline void throw_abort(char        const* message, int exit_code) { throw EAbort(message, exit_code); }
+    [[noreturn]] static inline void throw_abort(const std::string& message, int exit_code, size_t line = 0) { throw EAbort(message, exit_code, line); }
+    [[noreturn]] static inline void throw_abort(char        const* message, int exit_code, size_t line = 0) { throw EAbort(message, exit_code, line); }
 };
 
-[[noreturn]] inline void throw_abort(const std::string& message, int exit_code) { EAbort::throw_abort(message, exit_code); }
-[[noreturn]] inline void throw_abort(char        const* message, int exit_code) { EAbort::throw_abort(message, exit_code); }
+[[noreturn]] inline void throw_abort(const std::string& message, int exit_code, size_t line = 0) { EAbort::throw_abort(message, exit_code, line); }
+[[noreturn]] inline void throw_abort(char        const* message, int exit_code, size_t line = 0) { EAbort::throw_abort(message, exit_code, line); }
 
+//        (    )
+class ELine : public std::runtime_error {
+public:
+    using _Mybase = runtime_error;
+private:
+    size_t _line;
+public:
+    explicit ELine(std::string const& _Message, size_t line) : _Mybase(_Message.c_str()), _line(line) {}
+
+    [[nodiscard]] size_t line() const { return _line; }
+};
+
+
+// 64-  FNV-1a (  )
+struct THash {
+    uint64_t value{ 14695981039346656037ull };
+
+    THash& add(void const* data, size_t size) {
+        auto p = static_cast<unsigned char const*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            value ^= p[i];
+            value *= 1099511628211ull;
+        }
+        return *this;
+    }
+
+    THash& add(std::string_view str) { return add(str.data(), str.size()).add<uint8_t>(0); }
+
+    template <typename T> requires (std::is_trivially_copyable_v<T> and !std::is_pointer_v<T>)
+    THash& add(T val) { return add(&val, sizeof(val)); }
+};
 
 //      
 template <typename T>
@@ -48,7 +86,7 @@ private:
     std::ofstream* fout{ nullptr };
     size_t input_line{ 0 }; //      
 public:
-    TInOut(std::string const& input_file) {
+    TInOut(std::string const& input_file, bool binary_out = false) {
         is_console = (input_file == "");
         if (!is_console) {
             try {
@@ -57,7 +95,7 @@ public:
                 if (fin->fail()) throw std::runtime_error("   : \"" + input_file + "\"");
 
                 fout = new std::ofstream;
-                fout->open(input_file + ".out");
+                fout->open(input_file + ".out", binary_out ? std::ios::out | std::ios::binary : std::ios::out);
                 if (fout->fail()) throw std::runtime_error("   : \"" + input_file + ".out\"");
             }
             catch (...) {
@@ -91,6 +129,16 @@ public:
         return std::istringstream(std::move(s_buf));
     }
 
+    //    count   
+    [[nodiscard]] std::vector<std::string> ReadLines(size_t count) {
+        std::vector<std::string> lines(count);
+        for (auto& s_buf : lines) {
+            std::getline(IN(), s_buf);
+            ++input_line;
+        }
+        return lines;
+    }
+
     void IgnorLine() {
         std::string s_buf;
         std::getline(IN(), s_buf);
@@ -0,0 +1,335 @@
+/* ******************************************************************************************************** */
+/*                           ()                            */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif // _WIN32
+
+#include "my_graph.h"
+#include "ritm_test_suppor.h"
+
+//        :     
+//   ,   -    ,    .
+//     (,   ),   -   .gar
+//   .  :
+//   manifest.txt - "NV NE K",  K  "< > <NV > <NE >";
+//   map.bin      -   (uint32)   ,      ;
+//   shard_<k>.gar -  ( - shard_<k>.gar.out).
+//       ,       map.bin .
+
+//   (  )
+class TDisjointSets {
+private:
+    std::vector<size_t> parent;
+    std::vector<size_t> size;
+public:
+    explicit TDisjointSets(size_t count) : parent(count), size(count, 1) {
+        std::iota(parent.begin(), parent.end(), size_t{ 0 });
+    }
+
+    size_t Find(size_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    void Union(size_t a, size_t b) {
+        a = Find(a);
+        b = Find(b);
+        if (a == b) return;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+    }
+};
+
+//        
+class TNumberedLines {
+private:
+    std::ifstream IN;
+    size_t line{ 0 };
+public:
+    explicit TNumberedLines(std::filesystem::path const& file) : IN(file) {
+        if (IN.fail()) throw std::runtime_error("   : \"" + file.string() + "\"");
+    }
+
+    std::string Next() {
+        std::string s_buf;
+        std::getline(IN, s_buf);
+        ++line;
+        return s_buf;
+    }
+
+    size_t Line() const { return line; }
+};
+
+//   "v N" / "e N"    ( -  1)
+//   ,       on_ref
+inline std::string ForEachRef(std::string const& rule, std::function<size_t(Graph_Elem_Type, size_t)> const& on_ref) {
+    std::istringstream IN(rule);
+    std::string res, word;
+    while (IN >> word) {
+        if (!res.empty()) res += ' ';
+        res += word;
+        if (word == "v" or word == "e") {
+            size_t idx;
+            ReadValue(IN, idx);
+            res += ' ';
+            res += std::to_string(on_ref(word == "v" ? getVert : getEdge, idx));
+        }
+    }
+    return res;
+}
+
+//     
+inline void ReadSizes(TNumberedLines& lines, size_t& NV, size_t& NE) {
+    try {
+        std::istringstream line(lines.Next());
+        ReadValue(line, NV);
+        ReadValue(line, NE);
+    }
+    catch (const std::exception& exc) { throw_abort(exc.what(), 2, lines.Line()); }
+}
+
+//    
+inline void ReadEdge(TNumberedLines& lines, size_t NV, size_t& vi, size_t& vo) {
+    try {
+        std::istringstream line(lines.Next());
+        ReadValue(line, vi);
+        ReadValue(line, vo);
+    }
+    catch (const std::exception& exc) { throw_abort(exc.what(), 2, lines.Line()); }
+    if (vi == 0 or vo == 0 or vi > NV or vo > NV) throw_abort("Error in AddEdge(from, to): from|to >= vertex.size()", 3, lines.Line());
+}
+
+//    (        )
+inline constexpr size_t const max_shards = 256;
+
+//       shards    dir (   max_shards)
+//    
+inline std::vector<std::filesystem::path> SplitModel(std::filesystem::path const& input, std::filesystem::path const& dir, size_t shards) {
+    size_t NV, NE;
+
+    //  1:  
+    std::vector<uint32_t> shard_of; //    (,  )
+    {
+        TNumberedLines lines(input);
+        ReadSizes(lines, NV, NE);
+        TDisjointSets sets(NV + NE);
+
+        lines.Next();
+        for (size_t e = 0; e < NE; ++e) {
+            size_t vi, vo;
+            ReadEdge(lines, NV, vi, vo);
+            sets.Union(NV + e, vi - 1);
+            sets.Union(NV + e, vo - 1);
+        }
+        lines.Next();
+        for (size_t x = 0; x < NV + NE; ++x) {
+            std::string rule = lines.Next();
+            try {
+                ForEachRef(rule, [&](Graph_Elem_Type type, size_t idx) {
+                    if (idx == 0 or idx > (type == getVert ? NV : NE)) {
+                        throw std::runtime_error(std::string("Invalid reference: ") + (type == getVert ? "v " : "e ") + std::to_string(idx));
+                    }
+                    sets.Union(x, (type == getVert ? 0 : NV) + idx - 1);
+                    return idx;
+                });
+            }
+            catch (const EAbort&) { throw; }
+            catch (const std::exception& exc) { throw_abort(exc.what(), 2, lines.Line()); }
+        }
+
+        //  
+        std::vector<size_t> comp_size(NV + NE, 0);
+        for (size_t x = 0; x < NV + NE; ++x) ++comp_size[sets.Find(x)];
+
+        //  :   -    
+        std::vector<size_t> roots;
+        for (size_t x = 0; x < NV + NE; ++x) if (comp_size[x] > 0) roots.push_back(x);
+        std::sort(roots.begin(), roots.end(), [&](size_t a, size_t b) { return comp_size[a] > comp_size[b]; });
+
+        shards = std::max<size_t>(1, std::min({ shards, roots.size(), max_shards }));
+        using TLoad = std::pair<size_t, uint32_t>; // (, )
+        std::priority_queue<TLoad, std::vector<TLoad>, std::greater<TLoad>> load;
+        for (uint32_t k = 0; k < shards; ++k) load.emplace(0, k);
+
+        std::vector<uint32_t> shard_of_root(NV + NE, 0);
+        for (size_t r : roots) {
+            auto [l, k] = load.top();
+            load.pop();
+            shard_of_root[r] = k;
+            load.emplace(l + comp_size[r], k);
+        }
+
+        shard_of.resize(NV + NE);
+        for (size_t x = 0; x < NV + NE; ++x) shard_of[x] = shard_of_root[sets.Find(x)];
+    }
+
+    //    
+    std::vector<size_t> local(NV + NE);
+    std::vector<size_t> shard_nv(shards, 0), shard_ne(shards, 0);
+    for (size_t x = 0; x < NV; ++x) local[x] = shard_nv[shard_of[x]]++;
+    for (size_t x = NV; x < NV + NE; ++x) local[x] = shard_ne[shard_of[x]]++;
+
+    std::filesystem::create_directories(dir);
+    std::vector<std::filesystem::path> files(shards);
+    std::vector<std::ofstream> outs(shards);
+    for (size_t k = 0; k < shards; ++k) {
+        files[k] = dir / ("shard_" + std::to_string(k) + ".gar");
+        std::filesystem::remove(files[k].string() + ".out"); //   
+        outs[k].open(files[k]);
+        if (outs[k].fail()) throw std::runtime_error("   : \"" + files[k].string() + "\"");
+        outs[k] << shard_nv[k] << ' ' << shard_ne[k] << "\n\n";
+    }
+
+    //  2:    
+    {
+        TNumberedLines lines(input);
+        lines.Next();
+        lines.Next();
+        for (size_t e = 0; e < NE; ++e) {
+            size_t vi, vo;
+            ReadEdge(lines, NV, vi, vo);
+            outs[shard_of[NV + e]] << local[vi - 1] + 1 << ' ' << local[vo - 1] + 1 << '\n';
+        }
+        lines.Next();
+        for (auto& out : outs) out << '\n';
+        for (size_t x = 0; x < NV + NE; ++x) {
+            std::string rule = ForEachRef(lines.Next(), [&](Graph_Elem_Type type, size_t idx) {
+                return local[(type == getVert ? 0 : NV) + idx - 1] + 1;
+            });
+            outs[shard_of[x]] << rule << '\n';
+        }
+    }
+    for (size_t k = 0; k < shards; ++k) {
+        outs[k].close();
+        if (outs[k].fail()) throw std::runtime_error("   : \"" + files[k].string() + "\"");
+    }
+
+    std::ofstream manifest(dir / "manifest.txt");
+    manifest << NV << ' ' << NE << ' ' << shards << '\n';
+    for (size_t k = 0; k < shards; ++k) manifest << files[k].filename().string() << ' ' << shard_nv[k] << ' ' << shard_ne[k] << '\n';
+
+    std::ofstream map(dir / "map.bin", std::ios::binary);
+    map.write(reinterpret_cast<char const*>(shard_of.data()), shard_of.size() * sizeof(uint32_t));
+    if (manifest.fail() or map.fail()) throw std::runtime_error("    : \"" + dir.string() + "\"");
+
+    return files;
+}
+
+//       
+inline void JoinModel(std::filesystem::path const& dir, std::ostream& OUT) {
+    std::ifstream manifest(dir / "manifest.txt");
+    size_t NV, NE, shards;
+    if (!(manifest >> NV >> NE >> shards) or shards == 0 or shards > max_shards) throw std::runtime_error("   : \"" + (dir / "manifest.txt").string() + "\"");
+
+    std::vector<std::ifstream> outs(shards);
+    std::string failed; //  ,   
+    for (size_t k = 0; k < shards; ++k) {
+        std::string file;
+        size_t nv, ne;
+        manifest >> file >> nv >> ne;
+        std::filesystem::path out_file = dir / (file + ".out");
+
+        //   -  nv + ne  ,     
+        std::ifstream check(out_file);
+        std::string s_buf, text;
+        size_t count = 0;
+        bool ok = !check.fail();
+        while (ok and std::getline(check, s_buf)) {
+            ok = !s_buf.empty() and ++count <= nv + ne;
+        }
+        if (!ok or count != nv + ne) {
+            std::ifstream err(out_file);
+            while (std::getline(err, s_buf)) if (!s_buf.empty()) text += (text.empty() ? "" : " ") + s_buf;
+            if (!failed.empty()) failed += '\n';
+            failed += "Shard \"" + file + "\" failed: " + (text.empty() ? "no result" : text);
+            continue;
+        }
+        outs[k].open(out_file);
+        if (outs[k].fail()) throw std::runtime_error("   : \"" + out_file.string() + "\"");
+    }
+    if (!failed.empty()) throw std::runtime_error(failed);
+
+    std::ifstream map(dir / "map.bin", std::ios::binary);
+    std::string s_buf;
+    for (size_t x = 0; x < NV + NE; ++x) {
+        uint32_t k;
+        if (!map.read(reinterpret_cast<char*>(&k), sizeof(k)) or k >= shards) throw std::runtime_error("   : \"" + (dir / "map.bin").string() + "\"");
+        std::getline(outs[k], s_buf);
+        OUT << s_buf << '\n';
+    }
+}
+
+//      
+inline std::filesystem::path SelfPath(char const* argv0) {
+#ifdef _WIN32
+    wchar_t buf[MAX_PATH];
+    DWORD len = GetModuleFileNameW(nullptr, buf, MAX_PATH);
+    if (len > 0 and len < MAX_PATH) return std::filesystem::path(buf);
+#else
+    std::error_code ec;
+    auto p = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (!ec) return p;
+#endif // _WIN32
+    return std::filesystem::absolute(argv0);
+}
+
+//      ,    (-1 -   )
+inline int RunProcess(std::filesystem::path const& exe, std::vector<std::string> const& args) {
+#ifdef _WIN32
+    std::wstring cmd = L"\"" + exe.wstring() + L"\"";
+    for (auto const& arg : args) cmd += L" \"" + std::filesystem::path(arg).wstring() + L"\"";
+
+    STARTUPINFOW si{};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi{};
+    if (!CreateProcessW(nullptr, cmd.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) return -1;
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    DWORD code = static_cast<DWORD>(-1);
+    GetExitCodeProcess(pi.hProcess, &code);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return static_cast<int>(code);
+#else
+    std::string exe_str = exe.string();
+    std::vector<char*> argv;
+    argv.push_back(exe_str.data());
+    std::vector<std::string> args_copy(args);
+    for (auto& arg : args_copy) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (posix_spawn(&pid, exe_str.c_str(), nullptr, nullptr, argv.data(), environ) != 0) return -1;
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif // _WIN32
+}
@@ -0,0 +1,236 @@
+/* ******************************************************************************************************** */
+/*                          -,                                         */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <concepts>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+
+#include "my_graph.h"
+
+//   :   ,   TRules,    C++.
+// ,  "min v 2 e 1"   3  "- e 1 v 3"   2  :
+//
+//     using namespace static_rules;
+//     constexpr TStaticRules agent_func{
+//         vert_rule<3>(min(v<2>, e<1>)),
+//         edge_rule<2>(e<1> - v<3>),
+//     };
+//     agent_func.SetOn(graph);
+//
+//   (    )   1.
+//      ,     .
+namespace static_rules {
+
+    //    
+    struct TRef {
+        Graph_Elem_Type type;
+        size_t idx;
+
+        constexpr bool operator==(TRef const&) const = default;
+    };
+
+    template <size_t N, size_t M>
+    constexpr std::array<TRef, N + M> Join(std::array<TRef, N> const& a, std::array<TRef, M> const& b) {
+        std::array<TRef, N + M> res{};
+        for (size_t i = 0; i < N; ++i) res[i] = a[i];
+        for (size_t i = 0; i < M; ++i) res[N + i] = b[i];
+        return res;
+    }
+
+    //   
+    template <typename T>
+    concept CExpr = requires { T::is_rule_expr; };
+
+    // 
+    template <typename T>
+    struct TConst {
+        static constexpr bool is_rule_expr = true;
+        static constexpr std::array<TRef, 0> refs{};
+
+        T value;
+
+        template <typename TGraph>
+        constexpr auto operator()(TGraph&) const { return static_cast<typename TGraph::attr_value_type>(value); }
+    };
+
+    //   /
+    template <Graph_Elem_Type type, size_t idx>
+    struct TLink {
+        static_assert(idx > 0, "Element numbers start from 1");
+
+        static constexpr bool is_rule_expr = true;
+        static constexpr std::array<TRef, 1> refs{ TRef{ type, idx } };
+
+        template <typename TGraph>
+        constexpr auto operator()(TGraph& graph) const {
+            if constexpr (type == getVert) return graph.vertex[idx - 1].attribute;
+            else return graph.edge[idx - 1].attribute;
+        }
+    };
+
+    template <size_t idx> inline constexpr TLink<getVert, idx> v{};
+    template <size_t idx> inline constexpr TLink<getEdge, idx> e{};
+
+    //   
+    template <typename TOp, CExpr TL, CExpr TR>
+    struct TBinary {
+        static constexpr bool is_rule_expr = true;
+        static constexpr auto refs = Join(TL::refs, TR::refs);
+
+        TL l;
+        TR r;
+
+        template <typename TGraph>
+        constexpr auto operator()(TGraph& graph) const { return TOp{}(l(graph), r(graph)); }
+    };
+
+    //   ,    ,   complete_task
+    struct TMin { template <typename T> constexpr T operator()(T a, T b) const { return a < b ? a : b; } };
+    struct TMax { template <typename T> constexpr T operator()(T a, T b) const { return a > b ? a : b; } };
+
+    template <typename T>
+    constexpr auto MakeExpr(T val) {
+        if constexpr (CExpr<T>) return val;
+        else return TConst<T>{ val };
+    }
+
+    template <typename T>
+    concept COperand = CExpr<T> or std::is_arithmetic_v<T>;
+
+    template <typename TL, typename TR>
+    concept COperands = COperand<TL> and COperand<TR> and (CExpr<TL> or CExpr<TR>);
+
+    template <typename TOp, typename TL, typename TR>
+    constexpr auto MakeBinary(TL l, TR r) {
+        auto ll = MakeExpr(l);
+        auto rr = MakeExpr(r);
+        return TBinary<TOp, decltype(ll), decltype(rr)>{ ll, rr };
+    }
+
+    template <typename TL, typename TR> requires COperands<TL, TR>
+    constexpr auto operator+(TL l, TR r) { return MakeBinary<std::plus<>>(l, r); }
+
+    template <typename TL, typename TR> requires COperands<TL, TR>
+    constexpr auto operator-(TL l, TR r) { return MakeBinary<std::minus<>>(l, r); }
+
+    template <typename TL, typename TR> requires COperands<TL, TR>
+    constexpr auto operator*(TL l, TR r) { return MakeBinary<std::multiplies<>>(l, r); }
+
+    template <typename TL, typename TR> requires COperands<TL, TR>
+    constexpr auto operator/(TL l, TR r) { return MakeBinary<std::divides<>>(l, r); }
+
+    template <typename TL, typename TR> requires COperands<TL, TR>
+    constexpr auto min(TL l, TR r) { return MakeBinary<TMin>(l, r); }
+
+    template <typename TL, typename TR> requires COperands<TL, TR>
+    constexpr auto max(TL l, TR r) { return MakeBinary<TMax>(l, r); }
+
+    // :   = 
+    template <Graph_Elem_Type type, size_t idx, CExpr TExpr>
+    struct TStaticRule {
+        static_assert(idx > 0, "Element numbers start from 1");
+
+        static constexpr TRef target{ type, idx };
+        static constexpr auto refs = TExpr::refs;
+
+        TExpr expr;
+
+        template <typename TGraph>
+        void operator()(TGraph& graph) const {
+            auto val = expr(graph);
+            if constexpr (type == getVert) graph.vertex[idx - 1].attribute = val;
+            else graph.edge[idx - 1].attribute = val;
+        }
+    };
+
+    template <size_t idx, typename TExpr> requires COperand<TExpr>
+    constexpr auto vert_rule(TExpr expr) {
+        auto ex = MakeExpr(expr);
+        return TStaticRule<getVert, idx, decltype(ex)>{ ex };
+    }
+
+    template <size_t idx, typename TExpr> requires COperand<TExpr>
+    constexpr auto edge_rule(TExpr expr) {
+        auto ex = MakeExpr(expr);
+        return TStaticRule<getEdge, idx, decltype(ex)>{ ex };
+    }
+
+    //   (-)
+    template <typename... TRulesPack>
+    class TStaticRules {
+    private:
+        static constexpr size_t rules_count = sizeof...(TRulesPack);
+
+        std::tuple<TRulesPack...> rules;
+
+        //   :      ,    
+        static constexpr std::array<size_t, rules_count> TopSort() {
+            constexpr std::array<TRef, rules_count> targets{ TRulesPack::target... };
+            constexpr std::array<size_t, rules_count> refs_count{ TRulesPack::refs.size()... };
+            constexpr auto refs = [] {
+                std::array<TRef, (TRulesPack::refs.size() + ... + 0)> res{};
+                size_t k = 0;
+                ((std::copy(TRulesPack::refs.begin(), TRulesPack::refs.end(), res.begin() + k), k += TRulesPack::refs.size()), ...);
+                return res;
+            }();
+
+            for (size_t i = 0; i < rules_count; ++i)
+                for (size_t j = i + 1; j < rules_count; ++j)
+                    if (targets[i] == targets[j]) throw std::logic_error("Duplicate rule");
+
+            std::array<size_t, rules_count> order{};
+            std::array<bool, rules_count> done{};
+            for (size_t n = 0; n < rules_count; ++n) {
+                //   ,     
+                size_t found = rules_count;
+                for (size_t i = 0, first = 0; i < rules_count and found == rules_count; first += refs_count[i], ++i) {
+                    if (done[i]) continue;
+                    bool ready = true;
+                    for (size_t r = first; r < first + refs_count[i] and ready; ++r)
+                        for (size_t j = 0; j < rules_count; ++j)
+                            if (!done[j] and targets[j] == refs[r]) ready = false;
+                    if (ready) found = i;
+                }
+                if (found == rules_count) throw std::logic_error("Cycle detected");
+                done[found] = true;
+                order[n] = found;
+            }
+            return order;
+        }
+
+        static constexpr std::array<size_t, rules_count> order = TopSort();
+
+        template <typename TGraph, size_t... Is>
+        void Apply(TGraph& graph, std::index_sequence<Is...>) const {
+            (std::get<order[Is]>(rules)(graph), ...);
+        }
+
+        //   /,    
+        static constexpr size_t MaxIdx(Graph_Elem_Type type) {
+            size_t res = 0;
+            auto upd = [&](TRef const& r) { if (r.type == type and r.idx > res) res = r.idx; };
+            ((upd(TRulesPack::target), std::ranges::for_each(TRulesPack::refs, upd)), ...);
+            return res;
+        }
+
+    public:
+        constexpr TStaticRules(TRulesPack... rules) : rules(rules...) {}
+
+        //  -  
+        template <typename TGraph>
+        void SetOn(TGraph& graph) const {
+            if (MaxIdx(getVert) > graph.vertex.size() or MaxIdx(getEdge) > graph.edge.size()) {
+                throw std::invalid_argument("Error in SetOn(graph): rule refers to a missing vertex|edge");
+            }
+            Apply(graph, std::make_index_sequence<rules_count>{});
+        }
+    };
+
+} // namespace static_rules
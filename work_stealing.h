@@ -0,0 +1,92 @@
+/* ******************************************************************************************************** */
+/*                                                                             */
+/* ******************************************************************************************************** */
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+//  func(i, worker)  i  [0, count)  threads 
+//            ;   
+//       .     
+//   ,    ,    .
+//    func     .
+template <typename TFunc>
+void WorkStealingFor(size_t count, size_t threads, TFunc const& func) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, count));
+
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) func(i, size_t{ 0 });
+        return;
+    }
+
+    struct TRange {
+        std::mutex mutex;
+        size_t begin{ 0 };
+        size_t end{ 0 };
+    };
+
+    std::unique_ptr<TRange[]> ranges(new TRange[threads]);
+    for (size_t w = 0; w < threads; ++w) {
+        ranges[w].begin = count * w / threads;
+        ranges[w].end = count * (w + 1) / threads;
+    }
+
+    //     
+    auto take = [&](size_t w, size_t& idx) {
+        std::lock_guard lock(ranges[w].mutex);
+        if (ranges[w].begin == ranges[w].end) return false;
+        idx = ranges[w].begin++;
+        return true;
+    };
+
+    //       
+    // false -        
+    auto steal = [&](size_t w) {
+        for (;;) {
+            size_t victim = threads, best = 0;
+            for (size_t v = 0; v < threads; ++v) {
+                if (v == w) continue;
+                std::lock_guard lock(ranges[v].mutex);
+                size_t left = ranges[v].end - ranges[v].begin;
+                if (left > best) { best = left; victim = v; }
+            }
+            if (victim == threads) return false;
+
+            std::scoped_lock lock(ranges[victim].mutex, ranges[w].mutex);
+            size_t left = ranges[victim].end - ranges[victim].begin;
+            if (left == 0) continue; //    -  
+            size_t half = (left + 1) / 2;
+            ranges[w].begin = ranges[victim].end - half;
+            ranges[w].end = ranges[victim].end;
+            ranges[victim].end -= half;
+            return true;
+        }
+    };
+
+    std::vector<std::exception_ptr> errors(threads);
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads);
+        for (size_t w = 0; w < threads; ++w) {
+            workers.emplace_back([&, w] {
+                try {
+                    //       ,   ,
+                    //       
+                    size_t idx;
+                    for (;;) {
+                        if (take(w, idx)) func(idx, w);
+                        else if (!steal(w)) break;
+                    }
+                }
+                catch (...) { errors[w] = std::current_exception(); }
+            });
+        }
+    }
+    for (auto const& error : errors) if (error) std::rethrow_exception(error);
+}